@@ -0,0 +1,481 @@
+/* Bar rendering microbenchmark, run via make bar-bench.
+ *
+ * This program includes dusk itself and sets it up against the fixed configuration in
+ * bench/barbench.cfg on the headless X server that bench/bench.sh starts. That is the
+ * configuration of the window manager benchmarks with fallbacks for emoji and CJK text added to
+ * the fonts, so the colour schemes and the bar modules are the same. Nothing is read from or
+ * drawn to by other clients; the windows that the flexwintitle module shows are created and
+ * managed by this program directly.
+ *
+ * The following are timed over a corpus of window titles and status2d strings:
+ *    - drw_text and drw_fontset_getwidth_clamp
+ *    - drw_2dtext, with colours, rectangles, offsets and ^i images
+ *    - the size and draw functions of the workspaces module
+ *    - flextitlecalculate, both drawing and resolving a click, for 5 to 100 clients
+ *
+ * Every call is timed on its own following an untimed call that loads any fallback fonts and
+ * images. The number of allocations made per call, including those made by Xlib, Xft and
+ * fontconfig, is counted by wrapping malloc and friends. This relies on the glibc allocator being
+ * reachable as __libc_malloc and is left out elsewhere, in which case the allocations are null.
+ *
+ * The results are printed to standard output as JSON. */
+#define main dusk_main
+#include "../dusk.c"
+#undef main
+
+#define MAXRESULTS 64
+
+typedef struct {
+	const char *name;
+	char input[32];
+	int n;
+	double total;
+	double *samples; /* the time of each call, in ns */
+	long allocs;
+	long bytes;
+} Result;
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static const int countallocs = 1;
+static long allocs = 0;
+static long allocbytes = 0;
+
+void *
+malloc(size_t size)
+{
+	allocs++;
+	allocbytes += size;
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+	allocs++;
+	allocbytes += nmemb * size;
+	return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	allocs++;
+	allocbytes += size;
+	return __libc_realloc(ptr, size);
+}
+
+void
+free(void *ptr)
+{
+	__libc_free(ptr);
+}
+#else
+static const int countallocs = 0;
+static long allocs = 0;
+static long allocbytes = 0;
+#endif
+
+/* Runs the call the given number of times, recording the time and allocations of each */
+#define MEASURE(R, CALL) \
+	do { \
+		CALL; \
+		for (i = 0; i < iterations; i++) { \
+			a = allocs; \
+			b = allocbytes; \
+			start = now_ns(); \
+			CALL; \
+			record(R, start, allocs - a, allocbytes - b); \
+		} \
+	} while (0)
+
+static const struct {
+	const char *input;
+	const char *text;
+} titles[] = {
+	{ "ascii", "st - vim ~/src/dusk/lib/bar_flexwintitle.c" },
+	{ "latin1", "Müller & Söhne: Übersicht für Käufer (Größe 2×3)" },
+	{ "cjk", "東京の天気 - 晴れ時々曇り | 서울 날씨 | 北京天气预报" },
+	{ "emoji", "🎵 Now playing 🎧 ⏯ 🔊 | 💬 3 new messages 📧" },
+	{ "mixed", "Discord | #général — 日本語チャンネル 🎮 (42)" },
+	{ "long", "Mozilla Firefox - A very long window title that does not fit in the space that the "
+		"bar has to offer and therefore has to be truncated by the text drawing functions, which "
+		"measure the text glyph by glyph until the available width runs out - Private Browsing" },
+};
+
+/* Formats for the status2d corpus, %1$s is replaced with the path of a generated image */
+static const struct {
+	const char *input;
+	const char *format;
+} statuses[] = {
+	{ "plain", "  Mon 16 Oct 20:15  " },
+	{ "colours", "^c#ebcb8b^ 42%% ^c#a3be8c^ 3.1GHz ^d^^b#3b4252^ 16:20 ^d^" },
+	{ "rects", "^c#88c0d0^^r0,7,4,6^^f5^^r0,4,4,9^^f5^^r0,1,4,12^^f5^^d^ 87%% ^r0,h,w,1^" },
+	{ "images", "^i%1$s^^f18^ 23°C ^i%1$s^^f18^ 1.2 MB/s ^i%1$s^^f18^ 87%%" },
+	{ "offsets", "^fs^^c#bf616a^^r0,0,d,h^^fr^ cpu ^fx^^v^^C3^ mem ^t^^fp^ swap" },
+	{ "mixed", "^S1^^v^^b#2e3440^ 🔋 ^c#bf616a^^r0,5,20,8^^f22^^t^ 東京 ^C3^12:00 ^i%1$s^^f18^^d^" },
+};
+
+static const int clientcounts[] = { 5, 10, 25, 50, 100 };
+
+static Result results[MAXRESULTS];
+static int numresults = 0;
+static int iterations = 1000;
+static const char *label = "";
+static char imagepath[64];
+static Window *benchwins = NULL;
+static int numbenchwins = 0;
+
+static void
+usage(FILE *stream)
+{
+	fputs(
+		"usage: barbench [options]\n\n"
+		"Options:\n"
+		"  -i <iterations>       Calls timed per function and input (default 1000)\n"
+		"  -c <file>             Configuration to set up dusk with (default bench/barbench.cfg)\n"
+		"  -l <label>            Label recorded in the output, e.g. the commit being measured\n"
+		"\n", stream
+	);
+}
+
+static double
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static Result *
+newresult(const char *name, const char *input)
+{
+	Result *r;
+
+	if (numresults == LENGTH(results))
+		die("barbench: too many results");
+
+	r = &results[numresults++];
+	r->name = name;
+	strlcpy(r->input, input, sizeof r->input);
+	r->n = 0;
+	r->total = 0;
+	r->allocs = r->bytes = 0;
+	r->samples = ecalloc(iterations, sizeof(double));
+	return r;
+}
+
+static void
+record(Result *r, double start, long nallocs, long nbytes)
+{
+	double t = now_ns() - start;
+
+	r->samples[r->n++] = t;
+	r->total += t;
+	r->allocs += nallocs;
+	r->bytes += nbytes;
+}
+
+/* Writes a small gradient as a binary PPM for the ^i commands to load */
+static void
+writeimage(void)
+{
+	FILE *f;
+	int x, y;
+
+	snprintf(imagepath, sizeof imagepath, "/tmp/barbench-%d.ppm", (int)getpid());
+	if (!(f = fopen(imagepath, "wb")))
+		die("barbench: cannot write %s:", imagepath);
+
+	fprintf(f, "P6\n16 16\n255\n");
+	for (y = 0; y < 16; y++) {
+		for (x = 0; x < 16; x++) {
+			fputc(x * 16, f);
+			fputc(y * 16, f);
+			fputc(128, f);
+		}
+	}
+	fclose(f);
+}
+
+/* Sets up the arguments for a bar module in the same way as renderbarmodule does */
+static int
+modulearg(Bar *bar, int (*drawfunc)(Bar *bar, BarArg *a), BarArg *barg)
+{
+	const BarRule *br;
+	int r;
+
+	for (r = 0; r < num_barrules; r++) {
+		br = &_cfg_barrules[r];
+		if (br->drawfunc != drawfunc || !bar->s[r])
+			continue;
+		if ((br->monitor > -1 && br->monitor != bar->mon->num) || (br->bar > -1 && br->bar != bar->idx))
+			continue;
+
+		memset(barg, 0, sizeof(BarArg));
+		barg->lpad = br->lpad;
+		barg->rpad = br->rpad;
+		barg->value = br->value;
+		barg->scheme = (br->scheme > -1 ? br->scheme : SchemeNorm);
+		barg->firstscheme = barg->lastscheme = -1;
+		barg->x = bar->p[r];
+		barg->y = bar->borderpx;
+		barg->w = bar->s[r] + barg->lpad + barg->rpad;
+		barg->h = bar->bh - 2 * bar->borderpx;
+		return 1;
+	}
+	return 0;
+}
+
+static void
+openwindow(const char *class, const char *title)
+{
+	Window w;
+	XClassHint ch;
+	XWindowAttributes wa;
+
+	w = XCreateSimpleWindow(dpy, root, 0, 0, 200, 150, 0, 0, BlackPixel(dpy, screen));
+	ch.res_name = (char *)class;
+	ch.res_class = (char *)class;
+	XSetClassHint(dpy, w, &ch);
+	XStoreName(dpy, w, title);
+	XChangeProperty(dpy, w, netatom[NetWMName], utf8string, 8, PropModeReplace,
+		(unsigned char *)title, strlen(title));
+
+	benchwins = realloc(benchwins, ++numbenchwins * sizeof(Window));
+	if (!benchwins)
+		die("realloc:");
+	benchwins[numbenchwins - 1] = w;
+
+	/* The window manager is not subject to its own substructure redirect, so the window can
+	 * be managed right away rather than waiting for its map request. */
+	if (!XGetWindowAttributes(dpy, w, &wa))
+		die("barbench: cannot get the attributes of window %lu", w);
+	manage(w, &wa);
+}
+
+static void
+bench_text(Bar *bar)
+{
+	Result *r;
+	double start;
+	long a, b;
+	int i, t, w = bar->bw / 2;
+
+	drw_setbuf(drw, bar->buf);
+	drw_setscheme(drw, scheme[SchemeNorm]);
+
+	for (t = 0; t < LENGTH(titles); t++) {
+		r = newresult("drw_text", titles[t].input);
+		MEASURE(r, drw_text(drw, 0, 0, w, bar->bh, lrpad / 2, titles[t].text, 0, 1));
+	}
+
+	for (t = 0; t < LENGTH(titles); t++) {
+		r = newresult("drw_fontset_getwidth_clamp", titles[t].input);
+		MEASURE(r, drw_fontset_getwidth_clamp(drw, titles[t].text, w));
+	}
+}
+
+static void
+bench_2dtext(Bar *bar)
+{
+	Result *r;
+	double start;
+	long a, b;
+	int i, s, w;
+	char text[512];
+
+	drw_setbuf(drw, bar->buf);
+	drw_setscheme(drw, scheme[SchemeNorm]);
+
+	for (s = 0; s < LENGTH(statuses); s++) {
+		snprintf(text, sizeof text, statuses[s].format, imagepath);
+		w = status2dtextlength(text);
+		r = newresult("drw_2dtext", statuses[s].input);
+		MEASURE(r, drw_2dtext(drw, 0, 0, w, bar->bh, 0, text, 0, 1, SchemeNorm));
+	}
+}
+
+static void
+bench_flextitle(Bar *bar)
+{
+	Result *draw, *click;
+	BarArg barg;
+	Arg arg = {0};
+	double start;
+	long a, b;
+	int i, c, n = 0;
+	char title[256], input[32];
+
+	for (c = 0; c < LENGTH(clientcounts); c++) {
+		for (; n < clientcounts[c]; n++) {
+			snprintf(title, sizeof title, "%s [%d]", titles[n % LENGTH(titles)].text, n);
+			openwindow("bench1", title);
+		}
+
+		renderbar(bar);
+		if (!modulearg(bar, draw_flexwintitle, &barg))
+			die("barbench: the flexwintitle module is not shown on the bar");
+
+		snprintf(input, sizeof input, "%d clients", n);
+		draw = newresult("flextitlecalculate draw", input);
+		click = newresult("flextitlecalculate click", input);
+
+		drw_setbuf(drw, bar->buf);
+		drw_setscheme(drw, scheme[barg.scheme]);
+		MEASURE(draw, flextitlecalculate(bar, barg.x + barg.lpad, barg.w - barg.lpad - barg.rpad,
+			-1, flextitledraw, NULL, &barg));
+		MEASURE(click, flextitlecalculate(bar, 0, barg.w, barg.w / 2, flextitleclick, &arg, &barg));
+	}
+}
+
+static void
+bench_workspaces(Bar *bar)
+{
+	Result *size, *draw;
+	BarArg barg;
+	double start;
+	long a, b;
+	int i, c;
+	char class[32];
+
+	/* Occupy the other workspaces as well */
+	for (c = 2; c <= 9; c++) {
+		snprintf(class, sizeof class, "bench%d", c);
+		openwindow(class, titles[c % LENGTH(titles)].text);
+	}
+
+	renderbar(bar);
+	if (!modulearg(bar, draw_workspaces, &barg))
+		die("barbench: the workspaces module is not shown on the bar");
+
+	size = newresult("size_workspaces", "9 workspaces");
+	draw = newresult("draw_workspaces", "9 workspaces");
+
+	drw_setbuf(drw, bar->buf);
+	drw_setscheme(drw, scheme[barg.scheme]);
+	MEASURE(size, size_workspaces(bar, &barg));
+	MEASURE(draw, draw_workspaces(bar, &barg));
+}
+
+static int
+cmpdouble(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static double
+percentile(const Result *r, double p)
+{
+	return r->n ? r->samples[(int)(p * (r->n - 1) + 0.5)] : 0;
+}
+
+static void
+printresults(void)
+{
+	Result *r;
+	int i;
+	char allocs[32], bytes[32];
+
+	printf("{\n  \"label\": \"%s\",\n  \"iterations\": %d,\n  \"font_height\": %u,\n",
+		label, iterations, drw->fonts->h);
+	printf("  \"results\": [\n");
+	for (i = 0; i < numresults; i++) {
+		r = &results[i];
+		qsort(r->samples, r->n, sizeof(double), cmpdouble);
+		if (countallocs && r->n) {
+			snprintf(allocs, sizeof allocs, "%.2f", (double)r->allocs / r->n);
+			snprintf(bytes, sizeof bytes, "%.1f", (double)r->bytes / r->n);
+		} else {
+			strlcpy(allocs, "null", sizeof allocs);
+			strlcpy(bytes, "null", sizeof bytes);
+		}
+		printf("    { \"name\": \"%s\", \"input\": \"%s\", \"calls\": %d, \"mean_ns\": %.1f, "
+			"\"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f, \"max_ns\": %.1f, "
+			"\"allocs_per_call\": %s, \"bytes_per_call\": %s }%s\n",
+			r->name, r->input, r->n, r->n ? r->total / r->n : 0,
+			percentile(r, 0.5), percentile(r, 0.9), percentile(r, 0.99),
+			r->n ? r->samples[r->n - 1] : 0, allocs, bytes, i + 1 < numresults ? "," : "");
+	}
+	printf("  ]\n}\n");
+}
+
+static void
+parseargs(int argc, char *argv[])
+{
+	int i;
+
+	cfg_filename = "bench/barbench.cfg";
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+			usage(stdout);
+			exit(0);
+		} else if (i + 1 == argc) {
+			usage(stderr);
+			exit(1);
+		} else if (!strcmp(argv[i], "-i")) {
+			iterations = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-c")) {
+			cfg_filename = argv[++i];
+		} else if (!strcmp(argv[i], "-l")) {
+			label = argv[++i];
+		} else {
+			usage(stderr);
+			exit(1);
+		}
+	}
+
+	if (iterations < 1)
+		die("barbench: the number of iterations must be positive");
+}
+
+int
+main(int argc, char *argv[])
+{
+	Bar *bar;
+	int i;
+
+	parseargs(argc, argv);
+
+	if (!setlocale(LC_CTYPE, "") || !XSupportsLocale())
+		fputs("warning: no locale support\n", stderr);
+	if (!(dpy = XOpenDisplay(NULL)))
+		die("barbench: cannot open display");
+	if (!(xcon = XGetXCBConnection(dpy)))
+		die("barbench: cannot get xcb connection");
+
+	checkotherwm();
+	XrmInitialize();
+	setup();
+
+	for (bar = selmon->bar; bar && bar->external; bar = bar->next);
+	renderbar(bar);
+	if (!bar || !bar->buf)
+		die("barbench: the configuration has no bar to draw");
+
+	writeimage();
+	bench_text(bar);
+	bench_2dtext(bar);
+	bench_flextitle(bar);
+	bench_workspaces(bar);
+	printresults();
+
+	cleanup();
+	for (i = 0; i < numbenchwins; i++)
+		XDestroyWindow(dpy, benchwins[i]);
+	XCloseDisplay(dpy);
+	unlink(imagepath);
+
+	for (i = 0; i < numresults; i++)
+		free(results[i].samples);
+	free(benchwins);
+	return 0;
+}
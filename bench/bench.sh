@@ -0,0 +1,72 @@
+#!/bin/sh
+# Runs the dusk benchmark suite against a headless X server and prints the results as JSON.
+#
+# Usage: bench/bench.sh [loadgen options]
+#        bench/bench.sh bar [barbench options]
+#
+# dusk is started on a virtual display with the fixed configuration in bench/dusk.cfg, after
+# which bench/loadgen opens its windows and times the scenarios. Any arguments are passed on to
+# the load generator, e.g. "-n 200 -i 50" or "-s manage,viewws". Given bar as the first argument
+# the bar rendering benchmark in bench/barbench is run on the virtual display instead, which sets
+# up dusk by itself with bench/barbench.cfg, the same configuration with fallback fonts added.
+# The display can be changed by setting BENCH_DISPLAY, which defaults to :99, and the output of
+# dusk can be kept by setting BENCH_LOG to the file to write it to.
+#
+# Both Xvfb and a D-Bus session bus are required. If no session bus is available then the script
+# re-runs itself under dbus-run-session.
+
+cd "$(dirname "$0")/.." || exit 1
+
+if [ -z "$DBUS_SESSION_BUS_ADDRESS" ]; then
+	exec dbus-run-session -- "$0" "$@"
+fi
+
+DISPLAY=${BENCH_DISPLAY:-:99}
+export DISPLAY
+
+if [ "$1" = "bar" ]; then
+	shift
+	BINS="./bench/barbench"
+	TARGET=bar-bench
+else
+	BINS="./dusk ./duskc ./bench/loadgen"
+	TARGET=bench
+fi
+
+for bin in $BINS; do
+	[ -x "$bin" ] || { echo "bench: $bin not found, run make $TARGET" >&2; exit 1; }
+done
+
+Xvfb "$DISPLAY" -screen 0 1920x1080x24 -nolisten tcp >/dev/null 2>&1 &
+XVFB=$!
+DUSK=
+
+cleanup() {
+	[ -n "$DUSK" ] && kill "$DUSK" 2>/dev/null
+	kill "$XVFB" 2>/dev/null
+	wait 2>/dev/null
+}
+trap cleanup EXIT INT TERM
+
+# Wait for the X server and then for the window manager to register itself on the bus
+wait_for() {
+	i=0
+	until "$@" >/dev/null 2>&1; do
+		i=$((i + 1))
+		[ $i -gt 100 ] && { echo "bench: timed out waiting for $*" >&2; exit 1; }
+		sleep 0.1
+	done
+}
+
+wait_for test -e "/tmp/.X11-unix/X${DISPLAY#:}"
+
+if [ "$TARGET" = "bar-bench" ]; then
+	./bench/barbench -l "$(git rev-parse --short HEAD 2>/dev/null)" "$@"
+	exit
+fi
+
+./dusk -c bench/dusk.cfg 2>"${BENCH_LOG:-/dev/null}" &
+DUSK=$!
+wait_for ./duskc get_bar_height
+
+./bench/loadgen -l "$(git rev-parse --short HEAD 2>/dev/null)" "$@"
@@ -0,0 +1,514 @@
+/* Flextile layout microbenchmark and invariant checks, run via make layout-bench.
+ *
+ * The geometry of flextile lives in lib/layout_flextile-arrange.c and only records where each
+ * client goes in the layout plan. This program links that file against minimal stand-ins for
+ * the workspace and client structures, runs every combination of split layout, master axis and
+ * stack axis for 1 to N clients and reads the plan back rather than sending it to the X server.
+ *
+ * Each combination is first arranged without gaps and borders and with varying cfacts, and the
+ * result is checked for:
+ *    - every client being placed exactly once and within the workspace area
+ *    - tiled clients not overlapping each other
+ *    - the tiled clients covering the whole area, less rounding
+ *    - the size of clients arranged along a single axis being proportional to their cfacts
+ *
+ * Some arrangements do not satisfy all of these by design, e.g. the floating master sits on top
+ * of the stack and the grid leaves empty cells; see the tables below for the checks that apply.
+ * As the overlap check is quadratic the invariants are checked for up to 64 clients by default,
+ * as well as for the largest number of clients. The latter are arranged on an 8K area as there
+ * is not enough room on a 1080p screen for each of them to get a size of their own.
+ *
+ * The time spent per arrange is then measured with regular gaps and borders. The results are
+ * printed to standard output as JSON and any invariant violations are reported on standard
+ * error, in which case the exit status is 1. */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../util.c"
+
+#define arg(A) (!strcmp(argv[i], A))
+#define LENGTH(X) (sizeof X / sizeof X[0])
+#define MAXREPORTS 25 /* violations reported in detail */
+#define ROUNDING 1    /* pixels that a client may be off by due to integer division */
+
+/* Stand-ins for the parts of dusk that the flextile geometry relies on */
+#define False 0
+enum {
+	LAYOUT,
+	MASTER,
+	STACK,
+	STACK2,
+	LTAXIS_LAST,
+};
+
+static const uint64_t NoBorder = 0x4000000000;
+static const uint64_t Marked = 0x1; /* used by the checks below */
+
+typedef union {
+	long i;
+	unsigned long ui;
+	float f;
+	const void *v;
+} Arg;
+
+typedef struct Client Client;
+struct Client {
+	float mina, maxa;
+	float cfact;
+	int bw;
+	int area;
+	uint64_t flags;
+	Client *next;
+	Client *snext;
+};
+
+typedef struct {
+	int wx, wy, ww, wh;
+	float mfact;
+	int ltaxis[LTAXIS_LAST];
+	int nstack;
+	int nmaster;
+	Client *clients;
+	Client *stack;
+} Workspace;
+
+static int bh = 20;
+
+static Client *
+nexttiled(Client *c)
+{
+	return c;
+}
+
+static void
+addflag(Client *c, const uint64_t flag)
+{
+	c->flags |= flag;
+}
+
+static void
+skipfocusevents(void)
+{
+}
+
+#include "../lib/layout_flextile-deluxe.h"
+#include "../lib/layout_flextile-arrange.c"
+
+enum {
+	CheckOverlap = 1 << 0,
+	CheckCoverage = 1 << 1,
+	CheckCfacts = 1 << 2,
+	CheckBounds = 1 << 3,
+	CheckUntilSmall = 1 << 4, /* clients are stacked on top of each other once the tiles get too small */
+	CheckTiling = CheckOverlap|CheckCoverage|CheckBounds,
+	CheckAll = CheckTiling|CheckCfacts,
+};
+
+static const struct {
+	const char *name;
+	int checks;
+	int areas; /* areas that the split keeps even when there are no clients to fill them */
+} splits[] = {
+	{ "NO_SPLIT", CheckAll, 0 },
+	{ "SPLIT_VERTICAL", CheckAll, 0 },
+	{ "SPLIT_HORIZONTAL", CheckAll, 0 },
+	{ "SPLIT_CENTERED_VERTICAL", CheckAll, 0 },
+	{ "SPLIT_CENTERED_HORIZONTAL", CheckAll, 0 },
+	{ "SPLIT_VERTICAL_DUAL_STACK", CheckAll, 0 },
+	{ "SPLIT_HORIZONTAL_DUAL_STACK", CheckAll, 0 },
+	{ "FLOATING_MASTER", CheckCfacts|CheckBounds, 0 }, /* the master floats on top of the stack */
+	{ "SPLIT_VERTICAL_FIXED", CheckAll, 2 },
+	{ "SPLIT_HORIZONTAL_FIXED", CheckAll, 2 },
+	{ "SPLIT_CENTERED_VERTICAL_FIXED", CheckAll, 3 },
+	{ "SPLIT_CENTERED_HORIZONTAL_FIXED", CheckAll, 3 },
+	{ "SPLIT_VERTICAL_DUAL_STACK_FIXED", CheckAll, 3 },
+	{ "SPLIT_HORIZONTAL_DUAL_STACK_FIXED", CheckAll, 3 },
+	{ "FLOATING_MASTER_FIXED", CheckCfacts|CheckBounds, 2 },
+};
+
+static const struct {
+	const char *name;
+	int checks;
+	int tiles; /* clients that are tiled before the rest are stacked in the last tile, 0 for all */
+} axes[] = {
+	{ "TOP_TO_BOTTOM", CheckAll, 0 },
+	{ "LEFT_TO_RIGHT", CheckAll, 0 },
+	{ "MONOCLE", CheckTiling, 0 },
+	{ "GAPLESSGRID", CheckTiling, 0 },
+	{ "GAPLESSGRID_CFACTS", CheckTiling, 0 },
+	{ "GAPLESSGRID_ALT1", CheckTiling, 0 },
+	{ "GAPLESSGRID_ALT2", CheckTiling, 0 },
+	{ "GRIDMODE", CheckOverlap|CheckBounds, 0 }, /* cells are left empty when the grid is not full */
+	{ "HORIZGRID", CheckTiling, 0 },
+	{ "DWINDLE", CheckTiling|CheckUntilSmall, 0 },
+	{ "DWINDLE_CFACTS", CheckTiling|CheckUntilSmall, 9 },
+	{ "SPIRAL", CheckTiling|CheckUntilSmall, 0 },
+	{ "SPIRAL_CFACTS", CheckTiling|CheckUntilSmall, 9 },
+	{ "TATAMI", 0, 0 }, /* the mats can be off by a couple of pixels where the area does not divide evenly */
+	{ "TATAMI_CFACTS", 0, 0 },
+	{ "ASPECTGRID", CheckTiling, 0 },
+	{ "TOP_TO_BOTTOM_AR", CheckTiling, 0 },
+	{ "LEFT_TO_RIGHT_AR", CheckTiling, 0 },
+};
+
+typedef struct {
+	double ns;        /* total time spent arranging, in ns */
+	long arranges;
+	long clients;     /* sum of the number of clients over all arranges */
+	double nsatmax;   /* time per arrange for the largest number of clients */
+} Timing;
+
+static Workspace ws;
+static Client *clients = NULL;
+static int maxclients = 500;
+static int reps = 1;
+static int checkclients = 64;
+static int detail = 1;
+static long violations = 0;
+static long checked = 0;
+
+static void
+usage(FILE *stream)
+{
+	fputs(
+		"usage: layoutbench [options]\n\n"
+		"Options:\n"
+		"  -n <clients>          Arrange from 1 up to this many clients (default 500)\n"
+		"  -r <repetitions>      Times each arrange is repeated when timing (default 1)\n"
+		"  -c <clients>          Check invariants for up to this many clients (default 64)\n"
+		"  -q                    Leave out the timing of each individual combination\n"
+		"\n", stream
+	);
+}
+
+static double
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void
+setup(int n, int bw, int cfacts)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		clients[i].mina = clients[i].maxa = 0;
+		clients[i].cfact = cfacts ? 0.5 + (i % 4) * 0.5 : 1.0;
+		clients[i].bw = bw;
+		clients[i].area = 0;
+		clients[i].flags = 0;
+		clients[i].next = clients[i].snext = (i + 1 < n ? &clients[i + 1] : NULL);
+	}
+	ws.clients = ws.stack = clients;
+}
+
+static FlexDim
+area(int n, int gap, int scale)
+{
+	FlexDim d = {0};
+
+	d.x = ws.wx + gap;
+	d.y = ws.wy + gap;
+	d.w = ws.ww * scale - 2 * gap;
+	d.h = (ws.wh + bh) * scale - bh - 2 * gap;
+	d.ih = d.iv = gap;
+	d.n = d.an = n;
+	return d;
+}
+
+static void
+violation(int split, int master, int stack, int n, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (violations++ >= MAXREPORTS)
+		return;
+
+	fprintf(stderr, "%s / %s / %s with %d clients: ",
+		splits[split].name, axes[master].name, axes[stack].name, n);
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fputc('\n', stderr);
+}
+
+/* Returns the checks that apply to the given combination, given the areas that are in use */
+static int
+checksfor(int split, int n)
+{
+	int i, a, axis, checks = splits[split].checks, count[LTAXIS_LAST] = {0};
+	LayoutGeom *g;
+
+	/* Fixed splits leave the areas that have no clients empty */
+	if (n < ws.nmaster + splits[split].areas - 1)
+		checks &= ~CheckCoverage;
+
+	for (i = 0; i < layoutplanlen; i++)
+		count[layoutplan[i].c->area]++;
+
+	for (i = 0; i < layoutplanlen; i++) {
+		g = &layoutplan[i];
+		if (g->hide)
+			continue;
+		a = ws.ltaxis[g->c->area];
+		axis = axes[a].checks;
+		if (axes[a].tiles && count[g->c->area] > axes[a].tiles)
+			axis &= ~CheckTiling;
+		if ((axis & CheckUntilSmall) && (g->w < 2 * (bh + 1) || g->h < 2 * (bh + 1)))
+			axis &= ~CheckTiling;
+		checks &= axis | CheckCfacts;
+	}
+	return checks;
+}
+
+static void
+checkcfacts(int split, int master, int stack, int n, int grp)
+{
+	int i, total = 0, vertical, size;
+	float facts = 0, expected;
+	LayoutGeom *g;
+
+	vertical = ws.ltaxis[grp] == TOP_TO_BOTTOM;
+	for (i = 0; i < layoutplanlen; i++) {
+		g = &layoutplan[i];
+		if (g->c->area != grp || g->hide)
+			continue;
+		total += vertical ? g->h : g->w;
+		facts += g->c->cfact;
+	}
+
+	for (i = 0; i < layoutplanlen; i++) {
+		g = &layoutplan[i];
+		if (g->c->area != grp || g->hide)
+			continue;
+		size = vertical ? g->h : g->w;
+		expected = total * g->c->cfact / facts;
+		if (size < expected - 2 || size > expected + 2) {
+			violation(split, master, stack, n, "client %ld of area %d has size %d, expected %.1f given its cfact %.1f",
+				g->c - clients, grp, size, expected, g->c->cfact);
+			return;
+		}
+	}
+}
+
+static void
+check(int split, int master, int stack, int n, FlexDim d)
+{
+	int i, j, checks;
+	long covered = 0, slack;
+	LayoutGeom *a, *b;
+
+	checked++;
+	checks = checksfor(split, n);
+
+	if (layoutplanlen != n) {
+		violation(split, master, stack, n, "%d clients were placed", layoutplanlen);
+		return;
+	}
+
+	/* Every client is placed exactly once, the mark flag is used to tell */
+	for (i = 0; i < layoutplanlen; i++) {
+		if (layoutplan[i].c->flags & Marked) {
+			violation(split, master, stack, n, "client %ld was placed more than once",
+				layoutplan[i].c - clients);
+			return;
+		}
+		layoutplan[i].c->flags |= Marked;
+	}
+
+	for (i = 0; i < layoutplanlen; i++) {
+		a = &layoutplan[i];
+		if (a->hide)
+			continue;
+		if ((checks & CheckBounds) && (a->w <= 0 || a->h <= 0 || a->x < d.x || a->y < d.y
+				|| a->x + a->w > d.x + d.w + ROUNDING || a->y + a->h > d.y + d.h + ROUNDING)) {
+			violation(split, master, stack, n, "client %ld at %dx%d+%d+%d is outside of %dx%d+%d+%d",
+				a->c - clients, a->w, a->h, a->x, a->y, d.w, d.h, d.x, d.y);
+			return;
+		}
+		covered += (long)a->w * a->h;
+	}
+
+	if (checks & CheckOverlap) {
+		for (i = 0; i < layoutplanlen; i++) {
+			a = &layoutplan[i];
+			for (j = i + 1; j < layoutplanlen && !a->hide; j++) {
+				b = &layoutplan[j];
+				if (b->hide || a->x + ROUNDING >= b->x + b->w || b->x + ROUNDING >= a->x + a->w
+						|| a->y + ROUNDING >= b->y + b->h || b->y + ROUNDING >= a->y + a->h)
+					continue;
+				violation(split, master, stack, n, "clients %ld and %ld overlap",
+					a->c - clients, b->c - clients);
+				return;
+			}
+		}
+	}
+
+	/* Areas are split using integer division, allow for a pixel per client along each axis */
+	slack = (long)n * (d.w + d.h);
+	if ((checks & CheckCoverage) && labs((long)d.w * d.h - covered) > slack)
+		violation(split, master, stack, n, "clients cover %ld of %ld pixels", covered, (long)d.w * d.h);
+
+	if (checks & CheckCfacts)
+		for (i = MASTER; i < LTAXIS_LAST; i++)
+			if (axes[ws.ltaxis[i]].checks & CheckCfacts)
+				checkcfacts(split, master, stack, n, i);
+}
+
+static void
+run(int split, int master, int stack, Timing *t)
+{
+	int n, r;
+	double start, ns;
+	FlexDim d;
+
+	ws.ltaxis[LAYOUT] = split;
+	ws.ltaxis[MASTER] = master;
+	ws.ltaxis[STACK] = ws.ltaxis[STACK2] = stack;
+
+	memset(t, 0, sizeof(Timing));
+	for (n = 1; n <= maxclients; n++) {
+		if (n <= checkclients || n == maxclients) {
+			setup(n, 0, 1);
+			d = area(n, 0, n <= checkclients ? 1 : 4);
+			planlayout(&ws, d);
+			check(split, master, stack, n, d);
+		}
+
+		setup(n, 1, 0);
+		d = area(n, 5, 1);
+		start = now_ns();
+		for (r = 0; r < reps; r++)
+			planlayout(&ws, d);
+		ns = now_ns() - start;
+
+		t->ns += ns;
+		t->arranges += reps;
+		t->clients += (long)n * reps;
+		if (n == maxclients)
+			t->nsatmax = ns / reps;
+	}
+}
+
+static void
+printtiming(const char *indent, const Timing *t)
+{
+	printf("%s\"ns_per_arrange\": %.1f, \"ns_per_client\": %.2f, \"ns_per_arrange_at_max\": %.1f",
+		indent, t->ns / t->arranges, t->ns / t->clients, t->nsatmax);
+}
+
+static void
+parseargs(int argc, char *argv[])
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (arg("-h") || arg("--help")) {
+			usage(stdout);
+			exit(0);
+		} else if (arg("-q")) {
+			detail = 0;
+		} else if (i + 1 == argc) {
+			usage(stderr);
+			exit(1);
+		} else if (arg("-n")) {
+			maxclients = atoi(argv[++i]);
+		} else if (arg("-r")) {
+			reps = atoi(argv[++i]);
+		} else if (arg("-c")) {
+			checkclients = atoi(argv[++i]);
+		} else {
+			usage(stderr);
+			exit(1);
+		}
+	}
+
+	if (maxclients < 1 || reps < 1 || checkclients < 0)
+		die("layoutbench: the number of clients and repetitions must be positive");
+}
+
+int
+main(int argc, char *argv[])
+{
+	int s, m, a, num = 0;
+	Timing *t, splittotal[LENGTH(splits)] = {{0}}, axistotal[LENGTH(axes)] = {{0}};
+	Timing *timings;
+
+	parseargs(argc, argv);
+
+	ws.wx = 0;
+	ws.wy = bh;
+	ws.ww = 1920;
+	ws.wh = 1080 - bh;
+	ws.mfact = 0.55;
+	ws.nmaster = 2;
+	ws.nstack = 0;
+	clients = ecalloc(maxclients, sizeof(Client));
+	timings = ecalloc(LENGTH(splits) * LENGTH(axes) * LENGTH(axes), sizeof(Timing));
+
+	for (s = 0; s < LENGTH(splits); s++) {
+		for (m = 0; m < LENGTH(axes); m++) {
+			for (a = 0; a < LENGTH(axes); a++) {
+				t = &timings[num++];
+				run(s, m, a, t);
+				splittotal[s].ns += t->ns;
+				splittotal[s].arranges += t->arranges;
+				splittotal[s].clients += t->clients;
+				splittotal[s].nsatmax += t->nsatmax / (LENGTH(axes) * LENGTH(axes));
+				axistotal[a].ns += t->ns;
+				axistotal[a].arranges += t->arranges;
+				axistotal[a].clients += t->clients;
+				axistotal[a].nsatmax += t->nsatmax / (LENGTH(splits) * LENGTH(axes));
+			}
+		}
+	}
+
+	if (violations > MAXREPORTS)
+		fprintf(stderr, "... and %ld more\n", violations - MAXREPORTS);
+
+	printf("{\n  \"max_clients\": %d,\n  \"repetitions\": %d,\n  \"combinations\": %d,\n"
+		"  \"layouts_checked\": %ld,\n  \"violations\": %ld,\n", maxclients, reps, num, checked, violations);
+
+	printf("  \"splits\": [\n");
+	for (s = 0; s < LENGTH(splits); s++) {
+		printf("    { \"split\": \"%s\", ", splits[s].name);
+		printtiming("", &splittotal[s]);
+		printf(" }%s\n", s + 1 < LENGTH(splits) ? "," : "");
+	}
+
+	printf("  ],\n  \"stack_axes\": [\n");
+	for (a = 0; a < LENGTH(axes); a++) {
+		printf("    { \"axis\": \"%s\", ", axes[a].name);
+		printtiming("", &axistotal[a]);
+		printf(" }%s\n", a + 1 < LENGTH(axes) ? "," : "");
+	}
+	printf("  ]%s\n", detail ? "," : "");
+
+	if (detail) {
+		printf("  \"combinations_detail\": [\n");
+		for (s = 0, num = 0; s < LENGTH(splits); s++) {
+			for (m = 0; m < LENGTH(axes); m++) {
+				for (a = 0; a < LENGTH(axes); a++, num++) {
+					printf("    { \"split\": \"%s\", \"master\": \"%s\", \"stack\": \"%s\", ",
+						splits[s].name, axes[m].name, axes[a].name);
+					printtiming("", &timings[num]);
+					printf(" }%s\n", num + 1 < LENGTH(splits) * LENGTH(axes) * LENGTH(axes) ? "," : "");
+				}
+			}
+		}
+		printf("  ]\n");
+	}
+	printf("}\n");
+
+	free(layoutplan);
+	free(timings);
+	free(clients);
+	return violations ? 1 : 0;
+}
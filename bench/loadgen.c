@@ -0,0 +1,651 @@
+/* Synthetic client load generator for the dusk benchmark suite, see bench/bench.sh.
+ *
+ * Opens a number of windows against a running dusk and times a set of scenarios, driving the
+ * window manager through the X server as a regular client would (mapping windows, changing
+ * titles, sending ConfigureRequests and fullscreen requests) as well as through the same D-Bus
+ * methods that duskc calls. The results are printed to standard output as JSON.
+ *
+ * Every operation that is timed ends in a barrier; an XSync followed by an IPC round trip. As
+ * dusk handles all pending X events before it reads from the D-Bus connection the reply to the
+ * IPC call means that the window manager has dealt with everything that came before it. */
+#include <time.h>
+#include <unistd.h>
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+
+#define arg(A) (!strcmp(argv[i], A))
+#define LENGTH(X) (sizeof X / sizeof X[0])
+#define MAXCLASSES 9
+#define TIMEOUT 30000 /* ms to wait for the window manager before giving up */
+#define FLOODREVS 20   /* title revisions per window in each round of the titleflood scenario */
+
+#include "../util.c"
+#include "../lib/dbus_client.h"
+#include "../lib/dbus_client.c"
+
+typedef struct {
+	const char *name;
+	int ops;
+	int n;
+	double total;
+	long events;      /* X events handled by dusk during the rounds, when measured */
+	double *samples; /* the time of each timed round, in µs */
+} Result;
+
+enum {
+	NetClientList,
+	NetWMName,
+	NetWMState,
+	NetWMStateFullscreen,
+	NetSupportingWMCheck,
+	UTF8String,
+	WMDelete,
+	WMProtocols,
+	AtomLast
+};
+
+static Display *dpy;
+static Window root;
+static Window *wins = NULL;
+static Atom atoms[AtomLast];
+static char dbus_name[256];
+static const char *dbus_path = "/wm/dusk";
+static const char *dbus_interface = "wm.dusk";
+
+static int numwins = 50;
+static int numclasses = MAXCLASSES;
+static int iterations = 100;
+static int statusrate = 1000;
+static int minw = 0, minh = 0, incw = 0, inch = 0;
+static const char *titleprefix = "bench";
+static const char *label = "";
+static const char *scenarios = "manage,titles,titleflood,configure,fullscreen,viewws,relayout,setstatus,restart";
+
+static Result results[16];
+static int numresults = 0;
+
+static void
+usage(FILE *stream)
+{
+	fputs(
+		"usage: loadgen [options]\n\n"
+		"Options:\n"
+		"  -n <windows>          Number of windows to open (default 50)\n"
+		"  -c <classes>          Number of window classes, bench1 to bench9 (default 9)\n"
+		"  -i <iterations>       Iterations per scenario (default 100)\n"
+		"  -r <messages>         Status updates sent in the setstatus scenario (default 1000)\n"
+		"  -t <prefix>           Window title prefix (default bench)\n"
+		"  -m <w>x<h>            Minimum size hint of the windows\n"
+		"  -I <w>x<h>            Resize increment hint of the windows\n"
+		"  -s <list>             Comma separated scenarios to run, out of\n"
+		"                        manage,titles,titleflood,configure,fullscreen,viewws,relayout,\n"
+		"                        setstatus,restart\n"
+		"  -l <label>            Label recorded in the output, e.g. the commit being measured\n"
+		"\n", stream
+	);
+}
+
+static double
+now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int
+wants(const char *scenario)
+{
+	const char *s = scenarios;
+	size_t len = strlen(scenario);
+
+	for (s = scenarios; (s = strstr(s, scenario)); s += len)
+		if ((s == scenarios || s[-1] == ',') && (s[len] == ',' || s[len] == '\0'))
+			return 1;
+	return 0;
+}
+
+static Result *
+newresult(const char *name, int rounds)
+{
+	Result *r;
+
+	if (numresults == LENGTH(results))
+		die("loadgen: too many results");
+
+	r = &results[numresults++];
+	r->name = name;
+	r->ops = r->n = 0;
+	r->total = 0;
+	r->events = 0;
+	r->samples = ecalloc(rounds, sizeof(double));
+	return r;
+}
+
+/* Records a timed round made up of the given number of operations */
+static void
+record(Result *r, double start, int ops)
+{
+	double t = now_us() - start;
+
+	r->samples[r->n++] = t;
+	r->ops += ops;
+	r->total += t;
+}
+
+/* Calls the given method and, when wait is set, blocks until dusk has replied to it */
+static void
+ipc(const char *method, int wait, int type, ...)
+{
+	DBusMessage *msg, *reply;
+	va_list ap;
+
+	msg = create_dbus_message(dbus_name, dbus_path, dbus_interface, method);
+
+	va_start(ap, type);
+	for (; type != DBUS_TYPE_INVALID; type = va_arg(ap, int)) {
+		switch (type) {
+		case DBUS_TYPE_INT32:
+			add_int_argument(msg, va_arg(ap, int));
+			break;
+		case DBUS_TYPE_DOUBLE:
+			add_double_argument(msg, va_arg(ap, double));
+			break;
+		case DBUS_TYPE_STRING:
+			add_string_argument(msg, va_arg(ap, const char *));
+			break;
+		}
+	}
+	va_end(ap);
+
+	if (!wait) {
+		dbus_connection_send(dbus_conn, msg, NULL);
+		dbus_connection_flush(dbus_conn);
+		dbus_message_unref(msg);
+		return;
+	}
+
+	reply = dbus_connection_send_with_reply_and_block(dbus_conn, msg, TIMEOUT, &err);
+	if (dbus_error_is_set(&err))
+		die("loadgen: %s failed: %s", method, err.message);
+	dbus_message_unref(reply);
+	dbus_message_unref(msg);
+}
+
+/* Calls the given method with an optional window argument and copies the JSON reply to buf */
+static void
+query(const char *method, Window w, char *buf, size_t size)
+{
+	DBusMessage *msg, *reply;
+	char *response;
+
+	msg = create_dbus_message(dbus_name, dbus_path, dbus_interface, method);
+	if (w)
+		add_int_argument(msg, w);
+
+	reply = dbus_connection_send_with_reply_and_block(dbus_conn, msg, TIMEOUT, &err);
+	if (dbus_error_is_set(&err))
+		die("loadgen: %s failed: %s", method, err.message);
+	if (!dbus_message_get_args(reply, &err, DBUS_TYPE_STRING, &response, DBUS_TYPE_INVALID))
+		die("loadgen: %s failed: %s", method, err.message);
+	strlcpy(buf, response, size);
+	dbus_message_unref(reply);
+	dbus_message_unref(msg);
+}
+
+/* Returns the number of X events that dusk has handled so far */
+static long
+handledevents(void)
+{
+	char buf[256], *p;
+
+	query("get_sync_stats", None, buf, sizeof buf);
+	if (!(p = strstr(buf, "\"events\"")) || !(p = strchr(p, ':')))
+		die("loadgen: unexpected reply to get_sync_stats: %s", buf);
+	return strtol(p + 1, NULL, 10);
+}
+
+static void
+barrier(void)
+{
+	XSync(dpy, False);
+	ipc("get_bar_height", 1, DBUS_TYPE_INVALID);
+}
+
+static long
+numclients(void)
+{
+	Atom type;
+	int format;
+	unsigned long n = 0, extra;
+	unsigned char *p = NULL;
+
+	if (XGetWindowProperty(dpy, root, atoms[NetClientList], 0L, 0L, False, XA_WINDOW,
+			&type, &format, &n, &extra, &p) != Success)
+		return 0;
+	XFree(p);
+	return format == 32 ? extra / 4 : 0;
+}
+
+static Window
+wmcheck(void)
+{
+	Atom type;
+	int format;
+	unsigned long n = 0, extra;
+	unsigned char *p = NULL;
+	Window w = None;
+
+	if (XGetWindowProperty(dpy, root, atoms[NetSupportingWMCheck], 0L, 1L, False, XA_WINDOW,
+			&type, &format, &n, &extra, &p) == Success && n && p)
+		w = *(Window *)p;
+	XFree(p);
+	return w;
+}
+
+static void
+waitforclients(long n)
+{
+	double start = now_us();
+
+	while (numclients() != n) {
+		if (now_us() - start > TIMEOUT * 1e3)
+			die("loadgen: timed out waiting for %ld clients, have %ld", n, numclients());
+		usleep(500);
+	}
+}
+
+static void
+settitle(Window w, int i, int rev)
+{
+	char title[256];
+
+	snprintf(title, sizeof title, "%s %d - revision %d", titleprefix, i, rev);
+	XStoreName(dpy, w, title);
+	XChangeProperty(dpy, w, atoms[NetWMName], atoms[UTF8String], 8, PropModeReplace,
+		(unsigned char *)title, strlen(title));
+}
+
+static Window
+createwindow(int i)
+{
+	Window w;
+	XClassHint ch;
+	XSizeHints *sh;
+	char class[32];
+
+	w = XCreateSimpleWindow(dpy, root, 0, 0, 200 + i % 7 * 10, 150 + i % 5 * 10, 0, 0,
+		BlackPixel(dpy, DefaultScreen(dpy)));
+
+	snprintf(class, sizeof class, "bench%d", i % numclasses + 1);
+	ch.res_name = class;
+	ch.res_class = class;
+	XSetClassHint(dpy, w, &ch);
+
+	sh = XAllocSizeHints();
+	if (minw || minh) {
+		sh->flags |= PMinSize;
+		sh->min_width = minw;
+		sh->min_height = minh;
+	}
+	if (incw || inch) {
+		sh->flags |= PResizeInc;
+		sh->width_inc = incw;
+		sh->height_inc = inch;
+	}
+	XSetWMNormalHints(dpy, w, sh);
+	XFree(sh);
+
+	XSetWMProtocols(dpy, w, &atoms[WMDelete], 1);
+	settitle(w, i, 0);
+	return w;
+}
+
+static void
+togglefullscreen(Window w)
+{
+	XEvent ev = { 0 };
+
+	ev.xclient.type = ClientMessage;
+	ev.xclient.window = w;
+	ev.xclient.message_type = atoms[NetWMState];
+	ev.xclient.format = 32;
+	ev.xclient.data.l[0] = 2; /* _NET_WM_STATE_TOGGLE */
+	ev.xclient.data.l[1] = atoms[NetWMStateFullscreen];
+	ev.xclient.data.l[3] = 1; /* normal application */
+	XSendEvent(dpy, root, False, SubstructureNotifyMask|SubstructureRedirectMask, &ev);
+}
+
+static void
+bench_manage(void)
+{
+	Result *r = newresult("manage", 1);
+	double start;
+	int i;
+
+	for (i = 0; i < numwins; i++)
+		wins[i] = createwindow(i);
+	XSync(dpy, False);
+
+	start = now_us();
+	for (i = 0; i < numwins; i++)
+		XMapWindow(dpy, wins[i]);
+	XFlush(dpy);
+	waitforclients(numwins);
+	barrier();
+	record(r, start, numwins);
+}
+
+static void
+bench_titles(void)
+{
+	Result *r = newresult("titles", iterations);
+	double start;
+	int i, j;
+
+	for (i = 0; i < iterations; i++) {
+		start = now_us();
+		for (j = 0; j < numwins; j++)
+			settitle(wins[j], j, i + 1);
+		barrier();
+		record(r, start, numwins);
+	}
+}
+
+/* Sets many revisions of every title back to back, as a terminal running a busy program might,
+ * which dusk is to collapse into far fewer events than were sent. After the last round every
+ * client is checked to have ended up with the last revision of its title. */
+static void
+bench_titleflood(void)
+{
+	Result *r = newresult("titleflood", iterations);
+	char buf[4096], title[256];
+	double start;
+	long before;
+	int i, j, rev;
+
+	for (i = 0; i < iterations; i++) {
+		before = handledevents();
+		start = now_us();
+		for (rev = 1; rev <= FLOODREVS; rev++)
+			for (j = 0; j < numwins; j++)
+				settitle(wins[j], j, i * FLOODREVS + rev);
+		barrier();
+		record(r, start, numwins * FLOODREVS);
+		r->events += handledevents() - before;
+	}
+
+	for (j = 0; j < numwins; j++) {
+		query("get_client", wins[j], buf, sizeof buf);
+		snprintf(title, sizeof title, "\"%s %d - revision %d\"", titleprefix, j, iterations * FLOODREVS);
+		if (!strstr(buf, title))
+			die("loadgen: titleflood - window %d did not end up with title %s", j, title);
+	}
+}
+
+static void
+bench_configure(void)
+{
+	Result *r = newresult("configure", iterations);
+	double start;
+	int i, j;
+
+	for (i = 0; i < iterations; i++) {
+		start = now_us();
+		for (j = 0; j < numwins; j++)
+			XMoveResizeWindow(dpy, wins[j], 10 + i % 20, 10 + j % 20, 300 + i % 50, 200 + j % 50);
+		barrier();
+		record(r, start, numwins);
+	}
+}
+
+static void
+bench_fullscreen(void)
+{
+	Result *r = newresult("fullscreen", iterations);
+	double start;
+	int i;
+
+	/* The first window is on the first workspace through the bench1 client rule */
+	ipc("viewwsbyindex", 1, DBUS_TYPE_INT32, 0, DBUS_TYPE_INVALID);
+	for (i = 0; i < iterations; i++) {
+		start = now_us();
+		togglefullscreen(wins[0]);
+		barrier();
+		record(r, start, 1);
+	}
+
+	if (iterations % 2) {
+		togglefullscreen(wins[0]);
+		barrier();
+	}
+}
+
+static void
+bench_viewws(void)
+{
+	Result *r = newresult("viewwsbyindex", iterations);
+	double start;
+	int i;
+
+	for (i = 0; i < iterations; i++) {
+		start = now_us();
+		ipc("viewwsbyindex", 1, DBUS_TYPE_INT32, (i + 1) % numclasses, DBUS_TYPE_INVALID);
+		record(r, start, 1);
+	}
+}
+
+static void
+bench_relayout(void)
+{
+	Result *r = newresult("relayout", iterations);
+	double start;
+	int i;
+
+	ipc("viewwsbyindex", 1, DBUS_TYPE_INT32, 0, DBUS_TYPE_INVALID);
+	for (i = 0; i < iterations; i++) {
+		start = now_us();
+		switch (i % 4) {
+		case 0:
+			ipc("setlayout", 1, DBUS_TYPE_INT32, i / 4 % 7, DBUS_TYPE_INVALID);
+			break;
+		case 1:
+			ipc("setmfact", 1, DBUS_TYPE_DOUBLE, i % 8 < 4 ? 0.05 : -0.05, DBUS_TYPE_INVALID);
+			break;
+		case 2:
+			ipc("incnmaster", 1, DBUS_TYPE_INT32, i % 8 < 4 ? 1 : -1, DBUS_TYPE_INVALID);
+			break;
+		case 3:
+			/* Cycle through the stack arrangements, the lower bits select the stack axis */
+			ipc("setlayoutaxisex", 1, DBUS_TYPE_INT32, (i / 4 % 4) << 2 | 2, DBUS_TYPE_INVALID);
+			break;
+		}
+		record(r, start, 1);
+	}
+	ipc("setlayout", 1, DBUS_TYPE_INT32, 0, DBUS_TYPE_INVALID);
+}
+
+static void
+bench_setstatus(void)
+{
+	Result *r = newresult("setstatus", 1);
+	char status[64];
+	double start;
+	int i;
+
+	/* Status updates are fired off without waiting for each reply, as a status bar script would */
+	start = now_us();
+	for (i = 0; i < statusrate; i++) {
+		snprintf(status, sizeof status, "load %d.%02d | %d", i / 100, i % 100, i);
+		ipc("setstatus", 0, DBUS_TYPE_INT32, i % 2, DBUS_TYPE_STRING, status, DBUS_TYPE_INVALID);
+	}
+	barrier();
+	record(r, start, statusrate);
+}
+
+static void
+bench_restart(void)
+{
+	Result *r = newresult("restart", 1);
+	Window check = wmcheck();
+	double start;
+
+	start = now_us();
+	ipc("restart", 0, DBUS_TYPE_INVALID);
+	while (wmcheck() == check || wmcheck() == None) {
+		if (now_us() - start > TIMEOUT * 1e3)
+			die("loadgen: timed out waiting for dusk to restart");
+		usleep(500);
+	}
+	waitforclients(numwins);
+	barrier();
+	record(r, start, numwins);
+}
+
+static int
+cmpdouble(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static double
+percentile(const Result *r, double p)
+{
+	return r->n ? r->samples[(int)(p * (r->n - 1) + 0.5)] : 0;
+}
+
+static void
+printresults(void)
+{
+	Result *r;
+	int i;
+
+	printf("{\n  \"label\": \"%s\",\n  \"windows\": %d,\n  \"classes\": %d,\n  \"iterations\": %d,\n",
+		label, numwins, numclasses, iterations);
+	printf("  \"scenarios\": [\n");
+	for (i = 0; i < numresults; i++) {
+		r = &results[i];
+		qsort(r->samples, r->n, sizeof(double), cmpdouble);
+		printf("    { \"name\": \"%s\", \"ops\": %d, \"rounds\": %d, \"total_ms\": %.3f, "
+			"\"mean_op_us\": %.1f, \"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, "
+			"\"max_us\": %.1f",
+			r->name, r->ops, r->n, r->total / 1e3, r->ops ? r->total / r->ops : 0,
+			percentile(r, 0.5), percentile(r, 0.9), percentile(r, 0.99),
+			r->n ? r->samples[r->n - 1] : 0);
+		if (r->events)
+			printf(", \"events\": %ld", r->events);
+		printf(" }%s\n", i + 1 < numresults ? "," : "");
+	}
+	printf("  ]\n}\n");
+}
+
+static void
+parseargs(int argc, char *argv[])
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (arg("-h") || arg("--help")) {
+			usage(stdout);
+			exit(0);
+		} else if (i + 1 == argc) {
+			usage(stderr);
+			exit(1);
+		} else if (arg("-n")) {
+			numwins = atoi(argv[++i]);
+		} else if (arg("-c")) {
+			numclasses = MAX(1, MIN(MAXCLASSES, atoi(argv[++i])));
+		} else if (arg("-i")) {
+			iterations = atoi(argv[++i]);
+		} else if (arg("-r")) {
+			statusrate = atoi(argv[++i]);
+		} else if (arg("-t")) {
+			titleprefix = argv[++i];
+		} else if (arg("-m")) {
+			sscanf(argv[++i], "%dx%d", &minw, &minh);
+		} else if (arg("-I")) {
+			sscanf(argv[++i], "%dx%d", &incw, &inch);
+		} else if (arg("-s")) {
+			scenarios = argv[++i];
+		} else if (arg("-l")) {
+			label = argv[++i];
+		} else {
+			usage(stderr);
+			exit(1);
+		}
+	}
+
+	if (numwins < 1 || iterations < 1 || statusrate < 1)
+		die("loadgen: the number of windows, iterations and messages must be positive");
+}
+
+int
+main(int argc, char *argv[])
+{
+	char *names[AtomLast] = {
+		[NetClientList] = "_NET_CLIENT_LIST",
+		[NetWMName] = "_NET_WM_NAME",
+		[NetWMState] = "_NET_WM_STATE",
+		[NetWMStateFullscreen] = "_NET_WM_STATE_FULLSCREEN",
+		[NetSupportingWMCheck] = "_NET_SUPPORTING_WM_CHECK",
+		[UTF8String] = "UTF8_STRING",
+		[WMDelete] = "WM_DELETE_WINDOW",
+		[WMProtocols] = "WM_PROTOCOLS",
+	};
+	int i;
+
+	parseargs(argc, argv);
+
+	if (!(dpy = XOpenDisplay(NULL)))
+		die("loadgen: cannot open display");
+	root = DefaultRootWindow(dpy);
+	XInternAtoms(dpy, names, AtomLast, False, atoms);
+
+	init_dbus();
+	if (!dbus_init)
+		die("loadgen: cannot connect to the D-Bus session bus");
+	prepare_dbus_name(dbus_name, dbus_base_name);
+
+	if (!wmcheck())
+		die("loadgen: no window manager is running");
+	if (numclients())
+		die("loadgen: expected no other clients to be managed");
+
+	wins = ecalloc(numwins, sizeof(Window));
+
+	/* All other scenarios depend on the windows being managed */
+	bench_manage();
+	if (wants("titles"))
+		bench_titles();
+	if (wants("titleflood"))
+		bench_titleflood();
+	if (wants("configure"))
+		bench_configure();
+	if (wants("fullscreen"))
+		bench_fullscreen();
+	if (wants("viewws"))
+		bench_viewws();
+	if (wants("relayout"))
+		bench_relayout();
+	if (wants("setstatus"))
+		bench_setstatus();
+	if (wants("restart"))
+		bench_restart();
+
+	printresults();
+
+	for (i = 0; i < numwins; i++)
+		XDestroyWindow(dpy, wins[i]);
+	XSync(dpy, False);
+	XCloseDisplay(dpy);
+	cleanup_dbus();
+
+	for (i = 0; i < numresults; i++)
+		free(results[i].samples);
+	free(wins);
+	return 0;
+}
@@ -112,6 +112,7 @@ static uint64_t functionality = 0
 //	|ViewOnWs // follow a window to the workspace it is being moved to
 	|Xresources // add support for changing colours via Xresources
 //	|Debug // enables additional debug output
+//	|Profiling // records X requests, round-trips and time spent per event type and IPC command, see get_profile
 	|AltWindowTitles // show alternate window titles, if present
 //	|AltWorkspaceIcons // show the workspace name instead of the icons
 //	|GreedyMonitor // disables swap of workspaces between monitors
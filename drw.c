@@ -83,6 +83,34 @@ utf8decode(const char *c, long *u, size_t clen)
 	return len;
 }
 
+static unsigned long
+drw_buf_bytes(Drw *drw, DrwBuf *buf)
+{
+	return (unsigned long)buf->w * buf->h * (drw->depth > 16 ? 4 : drw->depth > 8 ? 2 : 1);
+}
+
+static void
+drw_buf_alloc(Drw *drw, DrwBuf *buf, unsigned int w, unsigned int h)
+{
+	buf->w = MAX(w, 1);
+	buf->h = MAX(h, 1);
+	buf->drawable = XCreatePixmap(drw->dpy, drw->root, buf->w, buf->h, drw->depth);
+	buf->picture = XRenderCreatePicture(drw->dpy, buf->drawable, XRenderFindVisualFormat(drw->dpy, drw->visual), 0, NULL);
+	drw->pixmapbytes += drw_buf_bytes(drw, buf);
+	drw->numpixmaps++;
+}
+
+static void
+drw_buf_release(Drw *drw, DrwBuf *buf)
+{
+	XRenderFreePicture(drw->dpy, buf->picture);
+	XFreePixmap(drw->dpy, buf->drawable);
+	drw->pixmapbytes -= drw_buf_bytes(drw, buf);
+	drw->numpixmaps--;
+	buf->picture = None;
+	buf->drawable = None;
+}
+
 Drw *
 drw_create(Display *dpy, int screen, Window root, unsigned int w, unsigned int h, Visual *visual, unsigned int depth, Colormap cmap)
 {
@@ -91,14 +119,12 @@ drw_create(Display *dpy, int screen, Window root, unsigned int w, unsigned int h
 	drw->dpy = dpy;
 	drw->screen = screen;
 	drw->root = root;
-	drw->w = w;
-	drw->h = h;
 
 	drw->visual = visual;
 	drw->depth = depth;
 	drw->cmap = cmap;
-	drw->drawable = XCreatePixmap(dpy, root, w, h, depth);
-	drw->picture = XRenderCreatePicture(dpy, drw->drawable, XRenderFindVisualFormat(dpy, visual), 0, NULL);
+	drw_buf_alloc(drw, &drw->defbuf, w, h);
+	drw_setbuf(drw, NULL);
 	drw->gc = XCreateGC(dpy, drw->drawable, 0, NULL);
 	XSetGraphicsExposures(dpy, drw->gc, 0);
 	XSetLineAttributes(dpy, drw->gc, 1, LineSolid, CapButt, JoinMiter);
@@ -112,26 +138,78 @@ drw_resize(Drw *drw, unsigned int w, unsigned int h)
 	if (!drw)
 		return;
 
-	drw->w = w;
-	drw->h = h;
-	if (drw->picture)
-		XRenderFreePicture(drw->dpy, drw->picture);
-	if (drw->drawable)
-		XFreePixmap(drw->dpy, drw->drawable);
-	drw->drawable = XCreatePixmap(drw->dpy, drw->root, w, h, drw->depth);
-	drw->picture = XRenderCreatePicture(drw->dpy, drw->drawable, XRenderFindVisualFormat(drw->dpy, drw->visual), 0, NULL);
+	drw_buf_resize(drw, &drw->defbuf, w, h);
 }
 
 void
 drw_free(Drw *drw)
 {
-	XRenderFreePicture(drw->dpy, drw->picture);
-	XFreePixmap(drw->dpy, drw->drawable);
+	int i;
+
+	for (i = 0; i < CLR_CACHE; i++) {
+		if (!drw->clrcache[i].name)
+			continue;
+		XftColorFree(drw->dpy, drw->visual, drw->cmap, &drw->clrcache[i].clr);
+		free(drw->clrcache[i].name);
+	}
+	for (i = 0; i < drw->numevicted; i++)
+		XftColorFree(drw->dpy, drw->visual, drw->cmap, &drw->evicted[i]);
+	free(drw->evicted);
+
+	drw_buf_release(drw, &drw->defbuf);
 	XFreeGC(drw->dpy, drw->gc);
 	drw_fontset_free(drw->fonts);
 	free(drw);
 }
 
+DrwBuf *
+drw_buf_create(Drw *drw, unsigned int w, unsigned int h)
+{
+	DrwBuf *buf = ecalloc(1, sizeof(DrwBuf));
+
+	drw_buf_alloc(drw, buf, w, h);
+	return buf;
+}
+
+/* The content of the buffer is lost if the size changes */
+void
+drw_buf_resize(Drw *drw, DrwBuf *buf, unsigned int w, unsigned int h)
+{
+	if (!drw || !buf || (buf->w == MAX(w, 1) && buf->h == MAX(h, 1)))
+		return;
+
+	drw_buf_release(drw, buf);
+	drw_buf_alloc(drw, buf, w, h);
+	if (drw->target == buf)
+		drw_setbuf(drw, buf);
+}
+
+void
+drw_buf_free(Drw *drw, DrwBuf *buf)
+{
+	if (!drw || !buf)
+		return;
+
+	if (drw->target == buf)
+		drw_setbuf(drw, NULL);
+	drw_buf_release(drw, buf);
+	free(buf);
+}
+
+/* Sets the buffer that subsequent drawing and drw_map calls operate on, NULL for the default */
+void
+drw_setbuf(Drw *drw, DrwBuf *buf)
+{
+	if (!drw)
+		return;
+
+	drw->target = buf ? buf : &drw->defbuf;
+	drw->drawable = drw->target->drawable;
+	drw->picture = drw->target->picture;
+	drw->w = drw->target->w;
+	drw->h = drw->target->h;
+}
+
 /* This function is an implementation detail. Library users should use
  * drw_fontset_create instead.
  */
@@ -190,11 +268,106 @@ xfont_create(Drw *drw, const char *fontname, FcPattern *fontpattern)
 	return font;
 }
 
+/* Forgets all cached glyphs and text widths for a font set, this needs to be done whenever a
+ * font is added to the fallback chain. */
+static void
+glyphcache_clear(Fnt *set)
+{
+	int i;
+
+	memset(set->latin, 0, sizeof(set->latin));
+	free(set->glyphs);
+	set->glyphs = NULL;
+	set->glyphsize = set->glyphcount = 0;
+
+	for (i = 0; i < TEXTW_CACHE; i++) {
+		free(set->widths[i].text);
+		set->widths[i].text = NULL;
+	}
+}
+
+static void
+glyphcache_grow(Fnt *set)
+{
+	unsigned int i, j, oldsize = set->glyphsize;
+	GlyphInfo *old = set->glyphs;
+
+	set->glyphsize = oldsize ? oldsize * 2 : 64;
+	set->glyphs = ecalloc(set->glyphsize, sizeof(GlyphInfo));
+
+	for (i = 0; i < oldsize; i++) {
+		if (!old[i].font)
+			continue;
+		for (j = (old[i].codepoint * 2654435761u) & (set->glyphsize - 1);
+		     set->glyphs[j].font;
+		     j = (j + 1) & (set->glyphsize - 1));
+		set->glyphs[j] = old[i];
+	}
+
+	free(old);
+}
+
+/* Returns the cache slot for the given codepoint. If the slot is empty (font is 0) then the
+ * caller is expected to fill it in. */
+static GlyphInfo *
+glyphcache_get(Fnt *set, long codepoint)
+{
+	unsigned int i;
+
+	if (codepoint >= 0 && codepoint < 256)
+		return &set->latin[codepoint];
+
+	if (set->glyphcount * 2 >= set->glyphsize)
+		glyphcache_grow(set);
+
+	for (i = (codepoint * 2654435761u) & (set->glyphsize - 1);
+	     set->glyphs[i].font && set->glyphs[i].codepoint != codepoint;
+	     i = (i + 1) & (set->glyphsize - 1));
+
+	if (!set->glyphs[i].font) {
+		set->glyphs[i].codepoint = codepoint;
+		set->glyphcount++;
+	}
+
+	return &set->glyphs[i];
+}
+
+/* Returns the first font in the set that has a glyph for the given codepoint, or NULL if
+ * none of them do. The advance of the glyph is placed in xoff. */
+static Fnt *
+glyphfont(Fnt *set, long codepoint, const char *text, int len, int *xoff)
+{
+	int i;
+	Fnt *font;
+	XGlyphInfo ext;
+	GlyphInfo *g = glyphcache_get(set, codepoint);
+
+	if (!g->font) {
+		g->font = -1;
+		for (i = 1, font = set; font; font = font->next, i++) {
+			if (XftCharExists(font->dpy, font->xfont, codepoint)) {
+				XftTextExtentsUtf8(font->dpy, font->xfont, (XftChar8 *)text, len, &ext);
+				g->font = i;
+				g->xoff = ext.xOff;
+				break;
+			}
+		}
+	}
+
+	if (g->font < 0)
+		return NULL;
+
+	for (i = 1, font = set; i < g->font; font = font->next, i++);
+	*xoff = g->xoff;
+	return font;
+}
+
 static void
 xfont_free(Fnt *font)
 {
 	if (!font)
 		return;
+	glyphcache_clear(font);
 	if (font->pattern)
 		FcPatternDestroy(font->pattern);
 	XftFontClose(font->dpy, font->xfont);
@@ -234,6 +407,7 @@ drw_font_add(Drw* drw, const char *font)
 	} else {
 		for (cur = drw->fonts; cur->next; cur = cur->next);
 		cur->next = ret;
+		glyphcache_clear(drw->fonts);
 	}
 
 	return ret;
@@ -248,6 +422,9 @@ drw_fontset_free(Fnt *font)
 	}
 }
 
+/* Colours are interned by name and alpha so that the same colour is only allocated once,
+ * regardless of how many colour schemes or status texts refer to it. The cache holds the colour
+ * as allocated, the alpha is applied to the pixel of the copy handed out. */
 void
 drw_clr_create(
 	Drw *drw,
@@ -255,12 +432,50 @@ drw_clr_create(
 	const char *clrname,
 	unsigned int alpha
 ) {
+	unsigned int i, hash = 5381;
+	const char *s;
+	ClrCacheEntry *e = NULL;
+
 	if (!drw || !dest || !clrname)
 		return;
 
-	if (!XftColorAllocName(drw->dpy, drw->visual, drw->cmap, clrname, dest))
+	for (s = clrname; *s; s++)
+		hash = hash * 33 + (unsigned char)*s;
+
+	for (i = 0; i < CLR_PROBE; i++) {
+		e = &drw->clrcache[(hash + i) % CLR_CACHE];
+		if (!e->name)
+			break;
+		if (!strcmp(e->name, clrname)) {
+			*dest = e->clr;
+			dest->pixel = (dest->pixel & 0x00ffffffU) | (alpha << 24);
+			return;
+		}
+	}
+
+	/* All candidate slots are taken, reuse the first one. The evicted colour can not be freed
+	 * yet as copies of it may still be held by colour schemes and compiled status texts, so it
+	 * is kept aside until the Drw is freed. */
+	if (i == CLR_PROBE) {
+		e = &drw->clrcache[hash % CLR_CACHE];
+		if (drw->numevicted == drw->maxevicted) {
+			drw->maxevicted = drw->maxevicted ? drw->maxevicted * 2 : 16;
+			if (!(drw->evicted = realloc(drw->evicted, drw->maxevicted * sizeof(Clr))))
+				die("realloc:");
+		}
+		drw->evicted[drw->numevicted++] = e->clr;
+		free(e->name);
+		e->name = NULL;
+	}
+
+	if (!XftColorAllocName(drw->dpy, drw->visual, drw->cmap, clrname, dest)) {
 		fprintf(stderr, "error, cannot allocate color '%s'\n", clrname);
+		dest->pixel = (dest->pixel & 0x00ffffffU) | (alpha << 24);
+		return;
+	}
 
+	e->name = strdup(clrname);
+	e->clr = *dest;
 	dest->pixel = (dest->pixel & 0x00ffffffU) | (alpha << 24);
 }
 
@@ -318,7 +533,7 @@ drw_rect(Drw *drw, int x, int y, unsigned int w, unsigned int h, int filled, int
 int
 drw_text(Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int lpad, const char *text, int invert, int fillbg)
 {
-	int i, ty = 0, ellipsis_x = 0, charexists = 0, overflow = 0;
+	int i, ty = 0, ellipsis_x = 0, charexists = 0, overflow = 0, xoff = 0;
 	unsigned int ew = 0, ellipsis_w = 0, ellipsis_len;
 	XftDraw *d = NULL;
 	Fnt *usedfont, *curfont, *nextfont;
@@ -369,32 +584,37 @@ drw_text(Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int lp
 		nextfont = NULL;
 		while (*text) {
 			utf8charlen = utf8decode(text, &utf8codepoint, UTF_SIZ);
-			for (curfont = drw->fonts; curfont; curfont = curfont->next) {
-				charexists = charexists || XftCharExists(drw->dpy, curfont->xfont, utf8codepoint);
-				if (charexists) {
-					XftTextExtentsUtf8(curfont->dpy, curfont->xfont, (XftChar8 *)text, utf8charlen, &ext);
-					/* Keep track of the last len and x-position where ellipsis fits */
-					if (ew + ellipsis_width <= w) {
-						ellipsis_x = x + ew;
-						ellipsis_w = w - ew;
-						ellipsis_len = utf8strlen;
-					}
-
-					if (ew + ext.xOff > w) {
-						overflow = 1;
-						/* called from drw_fontset_getwidth_clamp() which wants the width after overflow */
-						if (!render)
-							ew += ext.xOff;
-						else
-							utf8strlen = ellipsis_len;
-					} else if (curfont == usedfont) {
-						ew += ext.xOff;
-						utf8strlen += utf8charlen;
-						text += utf8charlen;
-					} else {
-						nextfont = curfont;
-					}
-					break;
+			if (charexists) {
+				/* No font has this glyph, it is drawn using the primary font regardless */
+				curfont = drw->fonts;
+				XftTextExtentsUtf8(curfont->dpy, curfont->xfont, (XftChar8 *)text, utf8charlen, &ext);
+				xoff = ext.xOff;
+			} else {
+				curfont = glyphfont(drw->fonts, utf8codepoint, text, utf8charlen, &xoff);
+				charexists = curfont != NULL;
+			}
+
+			if (charexists) {
+				/* Keep track of the last len and x-position where ellipsis fits */
+				if (ew + ellipsis_width <= w) {
+					ellipsis_x = x + ew;
+					ellipsis_w = w - ew;
+					ellipsis_len = utf8strlen;
+				}
+
+				if (ew + xoff > w) {
+					overflow = 1;
+					/* called from drw_fontset_getwidth_clamp() which wants the width after overflow */
+					if (!render)
+						ew += xoff;
+					else
+						utf8strlen = ellipsis_len;
+				} else if (curfont == usedfont) {
+					ew += xoff;
+					utf8strlen += utf8charlen;
+					text += utf8charlen;
+				} else {
+					nextfont = curfont;
 				}
 			}
 
@@ -458,6 +678,7 @@ drw_text(Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int lp
 					for (curfont = drw->fonts; curfont->next; curfont = curfont->next)
 						; /* NOP */
 					curfont->next = usedfont;
+					glyphcache_clear(drw->fonts);
 				} else {
 					xfont_free(usedfont);
 					nomatches.codepoint[++nomatches.idx % nomatches_len] = utf8codepoint;
@@ -547,9 +768,27 @@ drw_map(Drw *drw, Window win, int x, int y, unsigned int w, unsigned int h)
 unsigned int
 drw_fontset_getwidth(Drw *drw, const char *text)
 {
+	unsigned int w, hash = 5381;
+	const char *s;
+	TextWidth *tw;
+
 	if (!drw || !drw->fonts || !text)
 		return 0;
-	return drw_text(drw, 0, 0, 0, 0, 0, text, 0, 0);
+
+	for (s = text; *s; s++)
+		hash = hash * 33 + (unsigned char)*s;
+
+	tw = &drw->fonts->widths[hash % TEXTW_CACHE];
+	if (tw->text && !strcmp(tw->text, text))
+		return tw->w;
+
+	/* Measuring the text may add fallback fonts, which clears the cache */
+	w = drw_text(drw, 0, 0, 0, 0, 0, text, 0, 0);
+	tw = &drw->fonts->widths[hash % TEXTW_CACHE];
+	free(tw->text);
+	tw->text = strdup(text);
+	tw->w = w;
+	return w;
 }
 
 unsigned int
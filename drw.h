@@ -5,11 +5,30 @@ typedef struct {
 	Cursor cursor;
 } Cur;
 
+#define TEXTW_CACHE 128
+
+typedef struct {
+	long codepoint;
+	int font; /* 1-based index of the font in the fallback chain, 0 if not cached, -1 if none has it */
+	int xoff; /* horizontal advance of the glyph in that font */
+} GlyphInfo;
+
+typedef struct {
+	char *text;
+	unsigned int w;
+} TextWidth;
+
+/* The glyph and text width caches are only used for the first font in a font set */
 typedef struct Fnt {
 	Display *dpy;
 	unsigned int h;
 	XftFont *xfont;
 	FcPattern *pattern;
+	GlyphInfo latin[256];  /* ASCII and Latin-1, indexed by codepoint */
+	GlyphInfo *glyphs;     /* hash table for all other codepoints */
+	unsigned int glyphsize;
+	unsigned int glyphcount;
+	TextWidth widths[TEXTW_CACHE]; /* recently measured strings */
 	struct Fnt *next;
 } Fnt;
 
@@ -17,6 +36,21 @@ enum { ColFg, ColBg, ColBorder, ColCount }; /* Clr scheme index */
 enum { PwrlNone, PwrlRightArrow, PwrlLeftArrow, PwrlForwardSlash, PwrlBackslash, PwrlSolid, PwrlSolidRev };
 typedef XftColor Clr;
 
+#define CLR_CACHE 256
+#define CLR_PROBE 4
+
+typedef struct {
+	char *name;
+	Clr clr; /* without alpha, which is applied to the copies handed out */
+} ClrCacheEntry;
+
+/* An off-screen buffer to draw to, e.g. the back buffer of a bar */
+typedef struct {
+	unsigned int w, h;
+	Drawable drawable;
+	Picture picture;
+} DrwBuf;
+
 typedef struct {
 	unsigned int w, h;
 	Display *dpy;
@@ -30,6 +64,13 @@ typedef struct {
 	GC gc;
 	Clr *scheme;
 	Fnt *fonts;
+	ClrCacheEntry clrcache[CLR_CACHE]; /* allocated colours by name */
+	Clr *evicted;   /* colours evicted from the cache, freed along with the Drw */
+	unsigned int numevicted, maxevicted;
+	DrwBuf defbuf;  /* drawn to when no other buffer is set */
+	DrwBuf *target; /* the buffer that drawable and picture refer to */
+	unsigned long pixmapbytes; /* server memory held by all buffers */
+	unsigned int numpixmaps;
 } Drw;
 
 /* Drawable abstraction */
@@ -37,6 +78,12 @@ Drw *drw_create(Display *dpy, int screen, Window win, unsigned int w, unsigned i
 void drw_resize(Drw *drw, unsigned int w, unsigned int h);
 void drw_free(Drw *drw);
 
+/* Buffer abstraction */
+DrwBuf *drw_buf_create(Drw *drw, unsigned int w, unsigned int h);
+void drw_buf_resize(Drw *drw, DrwBuf *buf, unsigned int w, unsigned int h);
+void drw_buf_free(Drw *drw, DrwBuf *buf);
+void drw_setbuf(Drw *drw, DrwBuf *buf);
+
 /* Fnt abstraction */
 Fnt *drw_fontset_create(Drw* drw, const char *fonts[], size_t fontcount);
 Fnt *drw_font_add(Drw* drw, const char *font);
@@ -41,6 +41,8 @@
 #include <X11/extensions/Xinerama.h>
 #endif /* XINERAMA */
 #include <X11/Xft/Xft.h>
+#include <X11/Xlib-xcb.h>
+#include <xcb/res.h>
 #include <inttypes.h>
 #include <libconfig.h>
 
@@ -58,6 +60,7 @@
 #define Button8                 8
 #define Button9                 9
 #define NUM_STATUSES            10
+#define EVENTBATCH_MAX          512
 #define STATUS_BUFFER           512
 #define BUTTONMASK              (ButtonPressMask|ButtonReleaseMask)
 #define CLEANMASK(mask)         (mask & ~(numlockmask|LockMask) & (ShiftMask|ControlMask|Mod1Mask|Mod2Mask|Mod3Mask|Mod4Mask|Mod5Mask))
@@ -291,6 +294,7 @@ struct Client {
 	int oldx, oldy, oldw, oldh;
 	int basew, baseh, incw, inch, maxw, maxh, minw, minh;
 	int bw, oldbw;
+	int cfgx, cfgy, cfgw, cfgh, cfgbw;  /* geometry last sent by resizeclientpad, cfgw 0 if unknown */
 	int group;
 	int area;  /* arrangement area (master, stack, secondary stack) */
 	int scheme;
@@ -313,6 +317,7 @@ struct Client {
 	Picture icon;
 	uint64_t flags;
 	uint64_t prevflags;
+	uint64_t ipcstate;  /* fingerprint of the state last published to IPC subscribers, 0 if none */
 };
 
 typedef struct {
@@ -365,6 +370,7 @@ struct Monitor {
 	uint64_t wsmask;
 	uint64_t prevwsmask;
 	unsigned int borderpx;
+	uint64_t ipcstate;    /* fingerprint of the state last published to IPC subscribers */
 	Monitor *next;
 	Workspace *selws;
 	Workspace *nullws;
@@ -409,6 +415,8 @@ struct Workspace {
 	int pinned;  /* Whether workspace is pinned to assigned monitor or not */
 	int rule_pinned;   /* Was the workspace pinned to a monitor according to the original rule?    */
 	int rule_monitor;  /* Used when redistributing workspaces when monitors are added and removed. */
+	uint64_t ipcstate;   /* fingerprints of the state and layout last published to IPC subscribers */
+	uint64_t ipclayout;
 	Client *clients;
 	Client *sel;
 	Client *stack;
@@ -475,7 +483,11 @@ static Monitor *dirtomon(int dir);
 static Workspace *dirtows(int dir);
 static void entermon(Monitor *m, Client *next);
 static void enternotify(XEvent *e);
+static void dispatch(XEvent *ev);
+static int dispatchevents(void);
+static void coalesceevents(XEvent *evs, int n);
 static void expose(XEvent *e);
+static void flushrequests(void);
 static void focus(Client *c);
 static void focusin(XEvent *e);
 static void focusmon(const Arg *arg);
@@ -495,6 +507,7 @@ static void keypress(XEvent *e);
 static void keyrelease(XEvent *e);
 static void killclient(const Arg *arg);
 static void manage(Window w, XWindowAttributes *wa);
+static void managewindow(Window w, XWindowAttributes *wa);
 static void mappingnotify(XEvent *e);
 static void maprequest(XEvent *e);
 static void motionnotify(XEvent *e);
@@ -534,6 +547,7 @@ static void unfocus(Client *c, int setfocus, Client *nextfocus);
 static void unmanage(Client *c, int destroyed);
 static Workspace *unmapnotify(XUnmapEvent *ev);
 static void updateclientlist(void);
+static void writeclientlist(void);
 static int updategeom(int width, int height);
 static void updatelegacystatus(void);
 static void updatenumlockmask(void);
@@ -544,6 +558,7 @@ static void updatewmhints(Client *c);
 static Client *wintoclient(Window w);
 static Monitor *wintomon(Window w);
 static int xerror(Display *dpy, XErrorEvent *ee);
+static void xsync(void);
 static int xerrordummy(Display *dpy, XErrorEvent *ee);
 static int xerrorstart(Display *dpy, XErrorEvent *ee);
 static void zoom(const Arg *arg);
@@ -573,7 +588,19 @@ static int combo = 0;          /* used for combo keys */
 static int monitorchanged = 0; /* used for combo logic */
 static int grp_idx = 0;        /* used for grouping windows together */
 static int scanning = 0;       /* used to indicate that we are scanning for windows following restart */
+static unsigned int numscanned = 0; /* number of windows adopted by the last scan */
 static int arrange_focus_on_monocle = 1; /* used in focus to arrange monocle layouts on focus */
+static int skipenterpending = 0; /* EnterNotify events are to be skipped once the current event has been handled */
+static unsigned long num_handled_events = 0; /* X events handled, used together with num_syncs below */
+static unsigned long num_syncs = 0; /* round-trips made via xsync, see get_sync_stats */
+static int clientlistpending = 0; /* the client lists are to be published once the current event has been handled */
+static Window *clientlistbuf = NULL; /* scratch buffer used when building the client lists */
+static Window *clientlists[2] = { NULL, NULL }; /* last published client list and client list stacking */
+static unsigned int nclientlists[2] = { 0, 0 };
+static unsigned int clientlistsize = 0; /* allocated size of the above buffers */
+static XEvent *eventbatch = NULL; /* events read in one go by dispatchevents */
+static int eventbatchsize = 0;
+static int eventbatchnext = 0, eventbatchlen = 0; /* the events of the batch yet to be dispatched */
 
 /* Used by propertynotify to throttle repeating notifications */
 static int pn_prev_state = 0;
@@ -625,6 +652,7 @@ applyrules(Client *c)
 {
 	const Rule *r;
 	const char *class, *instance;
+	const uint64_t *matched;
 	Atom game_id = None, da = None, *win_types = NULL;
 	char *role = NULL;
 	int i, di;
@@ -634,13 +662,13 @@ applyrules(Client *c)
 	Workspace *ws = NULL;
 	XClassHint ch = { NULL, NULL };
 
-	if (XGetWindowProperty(dpy, c->win, netatom[NetWMWindowType], 0L, sizeof(Atom), False, XA_ATOM,
+	if (getwinprop(c->win, netatom[NetWMWindowType], 0L, sizeof(Atom), XA_ATOM,
 			&da, &di, &nitems, &dl, &p) == Success && p) {
 		win_types = (Atom *) p;
 	}
 
 	/* rule matching */
-	XGetClassHint(dpy, c->win, &ch);
+	getclasshint(c->win, &ch);
 	class    = ch.res_class ? ch.res_class : broken;
 	instance = ch.res_name  ? ch.res_name  : broken;
 	if (!gettextprop(c->win, wmatom[WMWindowRole], &role))
@@ -656,13 +684,12 @@ applyrules(Client *c)
 	if (enabled(Debug))
 		fprintf(stderr, "applyrules: new client %s (%ld), class = '%s', instance = '%s', role = '%s', wintype = '%ld'\n", c->name, c->win, class, instance, role, nitems ? win_types[0] : 0);
 
+	matched = matchclientrules(c->name, class, role, instance);
 	for (i = 0; i < num_client_rules; i++) {
+		if (!RULEMATCHED(matched, i))
+			continue;
 		r = &_cfg_clientrules[i];
-		if ((!r->title || strstr(c->name, r->title))
-		&& (!r->class || strstr(class, r->class))
-		&& (!r->role || strstr(role, r->role))
-		&& (!r->instance || strstr(instance, r->instance))
-		&& (!r->wintype || atomin(XInternAtom(dpy, r->wintype, False), win_types, nitems))
+		if ((!r->wintype || atomin(rulewintypes[i], win_types, nitems))
 		&& (r->transient == -1 || r->transient == transient))
 		{
 			c->flags |= Ruled | r->flags;
@@ -838,6 +865,7 @@ reapplyrules(Client *c)
 	} else if (ISFLOATING(c)) {
 		raiseclient(c);
 		XMoveResizeWindow(dpy, c->win, c->x, c->y, c->w, c->h);
+		c->cfgw = 0;
 		savefloats(c);
 	}
 
@@ -936,6 +964,8 @@ applysizehints(Client *c, int *x, int *y, int *w, int *h, int interact)
 void
 arrange(Workspace *ws)
 {
+	ProfileMark pm;
+
 	if (ws && !ws->visible) {
 		if (ws != ws->mon->selws)
 			return;
@@ -943,17 +973,21 @@ arrange(Workspace *ws)
 		showwsclients(ws->stack);
 	}
 
+	/* Held back until all windows have been adopted, see scan */
+	if (scanning)
+		return;
+
+	profbegin(&pm);
 	if (ws) {
 		arrangews(ws);
 		restack(ws);
 		drawbar(ws->mon);
-		return;
+	} else {
+		for (ws = workspaces; ws; ws = ws->next)
+			arrangews(ws);
+		drawbars();
 	}
-
-	for (ws = workspaces; ws; ws = ws->next)
-		arrangews(ws);
-
-	drawbars();
+	profend(&pm, profilesection(ProfArrange));
 }
 
 void
@@ -1059,9 +1093,9 @@ checkotherwm(void)
 	xerrorxlib = XSetErrorHandler(xerrorstart);
 	/* this causes an error if some other window manager is running */
 	XSelectInput(dpy, DefaultRootWindow(dpy), SubstructureRedirectMask);
-	XSync(dpy, False);
+	xsync();
 	XSetErrorHandler(xerror);
-	XSync(dpy, False);
+	xsync();
 }
 
 void
@@ -1092,6 +1126,9 @@ cleanup(void)
 			unmanage(ws->stack, 0);
 	}
 	XUngrabKey(dpy, AnyKey, AnyModifier, root);
+	#ifdef HAVE_DBUS
+	cleanup_ipc_socket();
+	#endif
 
 	while (mons)
 		cleanupmon(mons);
@@ -1105,7 +1142,7 @@ cleanup(void)
 			XDestroyWindow(dpy, systray->win);
 		}
 		free(systray);
-		XSync(dpy, False);
+		xsync();
 	}
 
 	for (ws = workspaces; ws; ws = next) {
@@ -1123,10 +1160,23 @@ cleanup(void)
 	cleanup2dimagebuffer();
 	cleanup_config();
 
+	winindexfree(&clientindex);
+	winindexfree(&systrayindex);
+	winindexfree(&barindex);
+	winindexfree(&pidindex);
+	freeproctree();
+	freeprofile();
+	free(layoutplan);
+	freekeyindex();
+	free(clientlistbuf);
+	free(eventbatch);
+	free(clientlists[0]);
+	free(clientlists[1]);
+
 	free(scheme);
 	XDestroyWindow(dpy, wmcheckwin);
 	drw_free(drw);
-	XSync(dpy, False);
+	xsync();
 	XSetInputFocus(dpy, PointerRoot, RevertToPointerRoot, CurrentTime);
 	XDeleteProperty(dpy, root, netatom[NetActiveWindow]);
 }
@@ -1134,6 +1184,9 @@ cleanup(void)
 void
 cleanupmon(Monitor *mon)
 {
+	#ifdef HAVE_DBUS
+	ipc_monitor_removed(mon);
+	#endif
 	detachmon(mon);
 	teardownnullws(mon);
 	if (running)
@@ -1553,7 +1606,6 @@ configurenotify(XConfigureEvent *ev)
 		}
 	}
 
-	drw_resize(drw, sw, sh);
 	updatebars();
 	setworkspaceareas();
 	setviewport();
@@ -1662,6 +1714,7 @@ configurerequest(XEvent *e)
 			savefloats(c);
 			if (ISVISIBLE(c)) {
 				XMoveResizeWindow(dpy, c->win, c->x, c->y, c->w, c->h);
+				c->cfgw = 0;
 			} else {
 				addflag(c, NeedResize);
 			}
@@ -1684,7 +1737,6 @@ configurerequest(XEvent *e)
 		wc.stack_mode = ev->detail;
 		XConfigureWindow(dpy, ev->window, ev->value_mask, &wc);
 	}
-	XSync(dpy, False);
 }
 
 Monitor *
@@ -1830,6 +1882,189 @@ dirtows(int dir)
 	return target == ws ? NULL : target;
 }
 
+/* Handles a single X event. Requests made by the handler are not synced one by one, instead any
+ * round-trip the handler asked for (e.g. to skip focus events caused by restacking) is made once
+ * after the handler has finished. */
+void
+dispatch(XEvent *ev)
+{
+	ProfileMark pm;
+	SlowEvent se;
+
+	profeventsubject(ev, &se);
+	profbegin(&pm);
+	if (handler[ev->type])
+		handler[ev->type](ev); /* call handler */
+	num_handled_events++;
+	flushrequests();
+	profslowevent(&se, profend(&pm, profileevent(ev->type)));
+}
+
+/* Reads the events that are queued, up to EVENTBATCH_MAX, and dispatches them after collapsing
+ * superseded events, see coalesceevents. A batch ends after any event whose handler may run its
+ * own event loop (e.g. moving a window with the mouse), so that loop sees the events that follow.
+ * Returns the number of events read. */
+int
+dispatchevents(void)
+{
+	int i, n = 0, queued;
+	XEvent *ev;
+
+	if (!(queued = XPending(dpy)))
+		return 0;
+
+	if (!eventbatchsize) {
+		eventbatchsize = EVENTBATCH_MAX;
+		eventbatch = ecalloc(eventbatchsize, sizeof(XEvent));
+	}
+
+	while (n < queued && n < eventbatchsize) {
+		ev = &eventbatch[n++];
+		XNextEvent(dpy, ev);
+		if (ev->type == KeyPress || ev->type == ButtonPress || ev->type == ClientMessage)
+			break;
+	}
+
+	coalesceevents(eventbatch, n);
+
+	eventbatchlen = n;
+	for (i = 0; i < n && running; i++) {
+		if (!eventbatch[i].type)
+			continue;
+		eventbatchnext = i + 1;
+		dispatch(&eventbatch[i]);
+	}
+	eventbatchnext = eventbatchlen = 0;
+
+	return n;
+}
+
+/* Collapses events within a batch that are superseded by a later event in the same batch:
+ *   - repeated property notifications for the same window and property, as the handler reads
+ *     the current value of the property anyway (both title properties count as the same one)
+ *   - configure requests for the same window, the value masks of which are merged into the last
+ *   - expose events for the same window, only the last with a count of 0 is relevant
+ *   - motion events for the same window, only the last one is relevant
+ * Events are never collapsed across a change in the window's life cycle, e.g. a configure request
+ * made before mapping is to be handled before managing. Each window has an epoch for this that is
+ * incremented by such changes, and only events of the same epoch are collapsed.
+ * Superseded events are marked by setting their type to 0. */
+void
+coalesceevents(XEvent *evs, int n)
+{
+	int i, j, h, size, type;
+	unsigned int epoch;
+	Atom atom;
+	Window win;
+	XEvent *ev;
+	XConfigureRequestEvent *k, *e;
+	struct {
+		int type;
+		Window win;
+		Atom atom;
+		unsigned int epoch;
+		int idx;
+	} *seen;
+
+	if (n < 2)
+		return;
+
+	/* Every event adds at most one entry, keeping the table at most half full */
+	for (size = 16; size < 2 * n; size *= 2);
+	seen = ecalloc(size, sizeof(*seen));
+
+	/* Walk the batch backwards so that the first event seen for a key is the one that is kept */
+	for (i = n - 1; i >= 0; i--) {
+		ev = &evs[i];
+		type = ev->type;
+		atom = None;
+
+		switch (ev->type) {
+		case MotionNotify:
+			win = ev->xmotion.window;
+			break;
+		case MapRequest:
+		case MapNotify:
+		case UnmapNotify:
+		case DestroyNotify:
+		case ReparentNotify:
+			/* The epoch of a window is kept in an entry of its own, using LASTEvent as type */
+			win = (ev->type == MapRequest ? ev->xmaprequest.window : ev->xmap.window);
+			type = LASTEvent;
+			break;
+		case Expose:
+			if (ev->xexpose.count) {
+				ev->type = 0;
+				continue;
+			}
+			win = ev->xexpose.window;
+			break;
+		case ConfigureRequest:
+			win = ev->xconfigurerequest.window;
+			break;
+		case PropertyNotify:
+			win = ev->xproperty.window;
+			atom = ev->xproperty.atom;
+			if (atom == XA_WM_NAME && win != root)
+				atom = netatom[NetWMName];
+			if (ev->xproperty.state == PropertyDelete)
+				atom = ~atom;
+			break;
+		default:
+			continue;
+		}
+
+		h = (int)(((uint64_t)win * 0x9E3779B97F4A7C15ULL) >> 32) & (size - 1);
+		for (; seen[h].type; h = (h + 1) & (size - 1))
+			if (seen[h].type == LASTEvent && seen[h].win == win)
+				break;
+
+		if (type == LASTEvent) {
+			seen[h].type = LASTEvent;
+			seen[h].win = win;
+			seen[h].epoch++;
+			continue;
+		}
+
+		epoch = seen[h].type ? seen[h].epoch : 0;
+		h = (int)(((uint64_t)(win ^ atom) * 0x9E3779B97F4A7C15ULL) >> 32) & (size - 1);
+		for (; seen[h].type; h = (h + 1) & (size - 1))
+			if (seen[h].type == type && seen[h].win == win && seen[h].atom == atom && seen[h].epoch == epoch)
+				break;
+
+		if (!seen[h].type) {
+			seen[h].type = type;
+			seen[h].win = win;
+			seen[h].atom = atom;
+			seen[h].epoch = epoch;
+			seen[h].idx = i;
+			continue;
+		}
+
+		if (ev->type == ConfigureRequest) {
+			k = &evs[seen[h].idx].xconfigurerequest;
+			e = &ev->xconfigurerequest;
+			for (j = 0; j < 7; j++) {
+				if (!(e->value_mask & (1 << j)) || (k->value_mask & (1 << j)))
+					continue;
+				switch (1 << j) {
+				case CWX: k->x = e->x; break;
+				case CWY: k->y = e->y; break;
+				case CWWidth: k->width = e->width; break;
+				case CWHeight: k->height = e->height; break;
+				case CWBorderWidth: k->border_width = e->border_width; break;
+				case CWSibling: k->above = e->above; break;
+				case CWStackMode: k->detail = e->detail; break;
+				}
+				k->value_mask |= (1 << j);
+			}
+		}
+		ev->type = 0;
+	}
+
+	free(seen);
+}
+
 void
 entermon(Monitor *m, Client *next)
 {
@@ -1889,9 +2124,38 @@ void
 expose(XEvent *e)
 {
 	Monitor *m;
+	Bar *bar;
 	XExposeEvent *ev = &e->xexpose;
-	if (ev->count == 0 && (m = wintomon(ev->window)))
-		drawbar(m);
+	if (ev->count == 0 && (m = wintomon(ev->window))) {
+		if ((bar = wintobar(ev->window)))
+			exposebar(bar);
+		else
+			drawbar(m);
+	}
+}
+
+/* Completes the requests queued while handling an event. A sync is only made if something
+ * depends on the X server having processed our requests, otherwise the output buffer is left
+ * to be flushed by the event loop before it blocks waiting for more events. */
+void
+flushrequests(void)
+{
+	XEvent ev;
+	int i;
+
+	writeclientlist();
+
+	if (!skipenterpending)
+		return;
+
+	skipenterpending = 0;
+	xsync();
+	while (XCheckMaskEvent(dpy, EnterWindowMask, &ev)); // skip any new EnterNotify events
+
+	/* Including those that were already read as part of the current batch */
+	for (i = eventbatchnext; i < eventbatchlen; i++)
+		if (eventbatch[i].type == EnterNotify)
+			eventbatch[i].type = 0;
 }
 
 void
@@ -1955,11 +2219,8 @@ focus(Client *c)
 		grabbuttons(c, 1);
 		setfocus(c);
 
-		if (enabled(FocusedOnTop)) {
+		if (enabled(FocusedOnTop))
 			restack(c->ws);
-		} else {
-			XSync(dpy, False);
-		}
 		XSetWindowBorder(dpy, c->win, scheme[clientscheme(c, c)][ColBorder].pixel);
 	} else {
 		XGetInputFocus(dpy, &focus_return, &revert_to_return);
@@ -2069,7 +2330,7 @@ getatomprop(Client *c, Atom prop, Atom req)
 	unsigned char *p = NULL;
 	Atom da, atom = None;
 
-	if (XGetWindowProperty(dpy, c->win, prop, 0L, sizeof atom, False, req,
+	if (getwinprop(c->win, prop, 0L, sizeof atom, req,
 		&da, &di, &dl, &dm, &p) == Success && p) {
 		atom = *(Atom *)p;
 		if (da == xatom[XembedInfo] && dl == 2)
@@ -2131,11 +2392,18 @@ int
 gettextprop(Window w, Atom atom, char **text)
 {
 	char **list = NULL;
-	int n;
+	int n, format;
+	unsigned long extra;
 	XTextProperty name;
 
-	if (!XGetTextProperty(dpy, w, &name, atom) || !name.nitems)
+	if (getwinprop(w, atom, 0L, 1000000L, AnyPropertyType, &name.encoding, &format,
+			&name.nitems, &extra, &name.value) != Success || name.encoding == None)
+		return 0;
+	name.format = format;
+	if (!name.nitems) {
+		XFree(name.value);
 		return 0;
+	}
 	if (name.encoding == XA_STRING) {
 		if (text != NULL) {
 			*text = strdup((char *)name.value);
@@ -2196,6 +2464,8 @@ grabkeys(void)
 		for (j = 0; j < LENGTH(modifiers); j++)
 			XGrabKey(dpy, key->keycode, key->mod | modifiers[j], root,
 					True, GrabModeAsync, GrabModeAsync);
+
+	buildkeyindex();
 }
 #else // keysyms
 void
@@ -2214,7 +2484,9 @@ grabkeys(void)
 	syms = XGetKeyboardMapping(dpy, start, end - start + 1, &skip);
 	if (!syms)
 		return;
+	memset(keycodesyms, 0, sizeof(keycodesyms));
 	for (k = start; k <= end; k++) {
+		keycodesyms[k & 0xFF] = syms[(k - start) * skip];
 		for (i = 0; i < num_key_bindings; i++) {
 			key = &_cfg_keys[i];
 			/* skip modifier codes, we do that ourselves */
@@ -2227,6 +2499,7 @@ grabkeys(void)
 		}
 	}
 	XFree(syms);
+	buildkeyindex();
 }
 #endif // USE_KEYCODES
 
@@ -2284,39 +2557,29 @@ isuniquegeom(XineramaScreenInfo *unique, size_t n, XineramaScreenInfo *info)
 void
 keypress(XEvent *e)
 {
-	unsigned int i;
-	#if !USE_KEYCODES
-	int keysyms_return;
-	KeySym* keysym;
-	#endif
+	unsigned int gen = keyindexgen, mod;
+	unsigned long code;
 	XKeyEvent *ev = &e->xkey;
-	Key *key;
+	KeyEntry *k;
 
 	prev_ptr_x = ev->x_root;
 	prev_ptr_y = ev->y_root;
 
 	ignore_marked = 0;
-	#if !USE_KEYCODES
-	keysym = XGetKeyboardMapping(dpy, (KeyCode)ev->keycode, 1, &keysyms_return);
-	#endif
-	for (i = 0; i < num_key_bindings; i++) {
-		key = &_cfg_keys[i];
-		if (
-			#if USE_KEYCODES
-			ev->keycode == key->keycode
-			#else
-			*keysym == key->keysym
-			#endif // USE_KEYCODES
-			&& ev->type == key->type
-			&& CLEANMASK(key->mod) == CLEANMASK(ev->state)
-			&& key->func
-		) {
-			key->func(&(key->arg));
+	#if USE_KEYCODES
+	code = ev->keycode;
+	#else
+	code = keycodesyms[ev->keycode & 0xFF];
+	#endif // USE_KEYCODES
+	mod = CLEANMASK(ev->state);
+	for (k = keyindexget(code, mod, ev->type); k; k = k->next) {
+		if (k->code == code && k->mod == mod && k->type == ev->type) {
+			k->key->func(&(k->key->arg));
+			/* The bindings may have been reloaded by the function */
+			if (gen != keyindexgen)
+				break;
 		}
 	}
-	#if !USE_KEYCODES
-	XFree(keysym);
-	#endif // USE_KEYCODES
 	ignore_marked = 1;
 
 	if (ev->type == KeyRelease)
@@ -2360,15 +2623,30 @@ killclient(const Arg *arg)
 		XSetErrorHandler(xerrordummy);
 		XSetCloseDownMode(dpy, DestroyAll);
 		XKillClient(dpy, c->win);
-		XSync(dpy, False);
+		xsync();
 		XSetErrorHandler(xerror);
 		XUngrabServer(dpy);
 		force_warp = 1;
 	}
 }
 
+/* The properties of the window are requested in one go before managing it, rather than one
+ * round trip at a time as each is read. */
 void
 manage(Window w, XWindowAttributes *wa)
+{
+	ProfileMark pm;
+
+	profbegin(&pm);
+	prefetchwindows(&w, 1);
+	expireproctree();
+	managewindow(w, wa);
+	releaseprefetch(w);
+	profend(&pm, profilesection(ProfManage));
+}
+
+void
+managewindow(Window w, XWindowAttributes *wa)
 {
 	Client *c = NULL, *t = NULL, *term = NULL;
 	Monitor *m = NULL;
@@ -2417,7 +2695,7 @@ manage(Window w, XWindowAttributes *wa)
 		c->ws = recttows(c->x + c->w / 2, c->y + c->h / 2, 1, 1);
 
 	if (!c->ws) {
-		if (XGetTransientForHint(dpy, w, &trans) && (t = wintoclient(trans))) {
+		if (gettransientfor(w, &trans) && (t = wintoclient(trans))) {
 			addflag(c, Transient);
 			c->ws = t->ws;
 		} else {
@@ -2451,9 +2729,16 @@ manage(Window w, XWindowAttributes *wa)
 		return;
 	}
 
+	winindexadd(&clientindex, w, c);
+
 	if (!ISTRANSIENT(c))
 		term = termforwin(c);
 
+	/* Only terminals are indexed by process, after looking for the terminal as the client is
+	 * not to find itself */
+	if (ISTERMINAL(c) && c->pid)
+		winindexadd(&pidindex, c->pid, c);
+
 	if (ISSTICKY(c)) {
 		detachws(stickyws);
 		attachws(stickyws, c->ws);
@@ -2555,10 +2840,7 @@ manage(Window w, XWindowAttributes *wa)
 		}
 	}
 
-	XChangeProperty(dpy, root, netatom[NetClientList], XA_WINDOW, 32, PropModeAppend,
-		(unsigned char *) &(c->win), 1);
-	XChangeProperty(dpy, root, netatom[NetClientListStacking], XA_WINDOW, 32, PropModePrepend,
-		(unsigned char *) &(c->win), 1);
+	updateclientlist();
 
 	if (focusclient) {
 		if (c->ws == selws && c->ws->sel != c) {
@@ -2593,8 +2875,10 @@ manage(Window w, XWindowAttributes *wa)
 	if (!ISTRUEFULLSCREEN(c) && !noborder(c, 0, 0, 0, 0))
 		restoreborder(c);
 
-	if (FREEFLOW(c))
+	if (FREEFLOW(c)) {
 		XMoveResizeWindow(dpy, c->win, c->x, c->y, c->w, c->h);
+		c->cfgw = 0;
+	}
 
 	arrange(c->ws);
 
@@ -2874,6 +3158,7 @@ void
 restart(const Arg *arg)
 {
 	restartwm = 1;
+	restarttime = now();
 	running = 0;
 }
 
@@ -3044,6 +3329,13 @@ resizeclientpad(Client *c, int x, int y, int w, int h, int tw, int th)
 {
 	XWindowChanges wc;
 
+	if (enabled(CenterSizeHintsClients) && ISTILED(c) && c->ws->layout->arrange) {
+		if (w != tw)
+			x += (tw - w) / 2;
+		if (h != th)
+			y += (th - h) / 2;
+	}
+
 	if (!ISLOCKED(c)) {
 		c->oldx = c->x;
 		c->oldy = c->y;
@@ -3057,13 +3349,6 @@ resizeclientpad(Client *c, int x, int y, int w, int h, int tw, int th)
 	c->w = wc.width = w;
 	c->h = wc.height = h;
 
-	if (enabled(CenterSizeHintsClients) && ISTILED(c) && c->ws->layout->arrange) {
-		if (w != tw)
-			c->x = wc.x += (tw - w) / 2;
-		if (h != th)
-			c->y = wc.y += (th - h) / 2;
-	}
-
 	if (MOVEPLACE(c)) {
 		addflag(c, NeedResize);
 		return;
@@ -3076,9 +3361,21 @@ resizeclientpad(Client *c, int x, int y, int w, int h, int tw, int th)
 	}
 
 	removeflag(c, NeedResize);
+
+	/* Nothing to tell the window or the X server if it already has this geometry */
+	if (wc.x == c->cfgx && wc.y == c->cfgy && wc.width == c->cfgw && wc.height == c->cfgh
+			&& wc.border_width == c->cfgbw) {
+		removeflag(c, NoBorder);
+		return;
+	}
+
 	XConfigureWindow(dpy, c->win, CWX|CWY|CWWidth|CWHeight|CWBorderWidth, &wc);
+	c->cfgx = wc.x;
+	c->cfgy = wc.y;
+	c->cfgw = wc.width;
+	c->cfgh = wc.height;
+	c->cfgbw = wc.border_width;
 	configure(c);
-	XSync(dpy, False);
 }
 
 void
@@ -3088,7 +3385,7 @@ restack(Workspace *ws)
 	Client *s, *raised;
 	XWindowChanges wc;
 
-	if (!c)
+	if (!c || scanning)
 		return;
 
 	raised = (enabled(FocusedOnTopTiled) || FREEFLOW(c) || ISTRUEFULLSCREEN(c) ? c : NULL);
@@ -3108,7 +3405,6 @@ restack(Workspace *ws)
 	if (raised)
 		raiseclient(raised);
 
-	XSync(dpy, False);
 	if (canwarp(c))
 		warp(c);
 
@@ -3130,7 +3426,8 @@ void
 run(void)
 {
 	int activity;
-	int dbus_fd;
+	int pending;
+	int dbus_fd = -1;
 	int dpy_fd;
 	int dbus_registered;
 	int max_fd;
@@ -3138,64 +3435,78 @@ run(void)
 	prepare_dbus_name(dbus_name, dbus_base_name);
 
 	unsigned long long last_dbus_attempt;
+	struct timeval timeout;
 	DBusMessage *msg;
-	XEvent ev;
+	ProfileMark pm;
 
-	XSync(dpy, False);
+	xsync();
+	setup_ipc_socket();
 	dbus_registered = register_dbus(dbus_name, &dbus_fd);
 	last_dbus_attempt = now();
 
 	/* Get the file descriptor for X11 */
 	dpy_fd = ConnectionNumber(dpy);
 
-	/* Temporary event loop in case dbus is not available */
-	while (running && !dbus_registered && !XNextEvent(dpy, &ev)) {
-		if (handler[ev.type]) {
-			handler[ev.type](&ev); /* call handler */
-		}
-
-		/* Attempt to register with dbus at most every 5 seconds */
-		if (now() - last_dbus_attempt > 5000) {
-			dbus_registered = register_dbus(dbus_name, &dbus_fd);
-			last_dbus_attempt = now();
-		}
-	}
-
 	/* Main event loop */
 	while (running) {
 
-		fd_set read_fds;
+		/* Draw the bars that have changed, publish changes to IPC subscribers and send any
+		 * requests still held in the output buffer before blocking */
+		flushbars();
+		flush_ipc_clients();
+		XFlush(dpy);
+
+		fd_set read_fds, write_fds;
 		FD_ZERO(&read_fds);
-		FD_SET(dbus_fd, &read_fds); // watch D-Bus socket
+		FD_ZERO(&write_fds);
 		FD_SET(dpy_fd, &read_fds);  // watch X11 socket
+		max_fd = dpy_fd;
 
-		max_fd = (dbus_fd > dpy_fd) ? dbus_fd : dpy_fd;
+		if (dbus_registered) {
+			FD_SET(dbus_fd, &read_fds); // watch D-Bus socket
+			max_fd = MAX(max_fd, dbus_fd);
+		}
 
-		/* Wait for events on either D-Bus or X11 */
-		activity = select(max_fd + 1, &read_fds, NULL, NULL, NULL);
+		max_fd = set_ipc_fds(&read_fds, &write_fds, max_fd); // watch the IPC socket and its clients
 
-		if (activity < 0) {
+		/* Wait for events on either D-Bus, the IPC socket or X11. If D-Bus is not available
+		 * then another attempt to register is made at most every 5 seconds. Events that Xlib
+		 * has already read off the connection, e.g. during the round trips of an IPC command,
+		 * do not make the X socket readable, so there is no waiting while any are queued. */
+		pending = QLength(dpy);
+		timeout.tv_sec = pending ? 0 : 5;
+		timeout.tv_usec = 0;
+		activity = select(max_fd + 1, &read_fds, &write_fds, NULL,
+			dbus_registered && !pending ? NULL : &timeout);
+
+		if (!dbus_registered && now() - last_dbus_attempt > 5000) {
+			dbus_registered = register_dbus(dbus_name, &dbus_fd);
+			last_dbus_attempt = now();
+		}
+
+		if (activity < 0 || (!activity && !pending)) {
 			continue;
 		}
 
 		/* Handle X events */
-		if (FD_ISSET(dpy_fd, &read_fds)) {
-			while (XPending(dpy)) {
-				XNextEvent(dpy, &ev);
-				if (handler[ev.type]) {
-					handler[ev.type](&ev); /* call X event handler */
-				}
-			}
+		if (pending || FD_ISSET(dpy_fd, &read_fds)) {
+			while (running && dispatchevents());
 		}
 
+		/* Handle requests on the IPC socket */
+		handle_ipc_fds(&read_fds, &write_fds);
+
 		/* Handle D-Bus messages */
-		if (FD_ISSET(dbus_fd, &read_fds)) {
+		if (dbus_registered && FD_ISSET(dbus_fd, &read_fds)) {
 
 			/* Non-blocking read of the next available message */
 			dbus_connection_read_write(dbus_conn, 0);
 
 			while ((msg = dbus_connection_pop_message(dbus_conn)) != NULL) {
+				profbegin(&pm);
 				handle_dbus_message(msg); /* call dbus handler */
+				flushrequests();
+				profend(&pm, profilecommand(dbus_message_get_member(msg)));
 				dbus_message_unref(msg);
 			}
 		}
@@ -3207,42 +3518,140 @@ run(void)
 {
 	XEvent ev;
 	/* main event loop */
-	XSync(dpy, False);
-	while (running && !XNextEvent(dpy, &ev))
-		if (handler[ev.type])
-			handler[ev.type](&ev); /* call handler */
+	xsync();
+	while (running) {
+		flushbars();
+		XNextEvent(dpy, &ev);
+		XPutBackEvent(dpy, &ev);
+		dispatchevents();
+	}
 }
 #endif // HAVE_DBUS
 
+/* Adopts the existing windows following a restart. The attributes, geometry, transient hint and
+ * WM_STATE of every child of the root window are requested in one go and the per window manage
+ * properties are prefetched in bulk before managing any of them. Arranging, restacking and
+ * drawing the bar is held back while scanning and done once for all monitors at the end. */
 void
 scan(void)
 {
-	unsigned int i, num;
-	Window d1, d2, *wins = NULL;
-	XWindowAttributes wa;
+	unsigned int i, k, num, n = 0;
+	Window d1, d2, *wins = NULL, *adopt;
+	XWindowAttributes *was;
+	Monitor *m;
+	int *candidate, *transient, *adoptable, *adoptidx;
+	long state;
+	xcb_get_window_attributes_cookie_t *attrcookies;
+	xcb_get_geometry_cookie_t *geomcookies;
+	xcb_get_property_cookie_t *transcookies, *statecookies;
+	xcb_get_window_attributes_reply_t *attr;
+	xcb_get_geometry_reply_t *geom;
+	xcb_get_property_reply_t *trans, *wmstate;
+	xcb_generic_error_t *e;
+
+	if (!XQueryTree(dpy, root, &d1, &d2, &wins, &num))
+		return;
 
 	scanning = 1;
-	if (XQueryTree(dpy, root, &d1, &d2, &wins, &num)) {
-		for (i = 0; i < num; i++) {
-			if (!XGetWindowAttributes(dpy, wins[i], &wa)
-			|| wa.override_redirect || XGetTransientForHint(dpy, wins[i], &d1))
-				continue;
-			if (mapexternalbar(wins[i]))
-				continue;
-			if (wa.map_state == IsViewable || getstate(wins[i]) == IconicState)
-				manage(wins[i], &wa);
+	was = ecalloc(num + 1, sizeof(XWindowAttributes));
+	candidate = ecalloc(num + 1, sizeof(int));
+	transient = ecalloc(num + 1, sizeof(int));
+	adoptable = ecalloc(num + 1, sizeof(int));
+	adopt = ecalloc(num + 1, sizeof(Window));
+	adoptidx = ecalloc(num + 1, sizeof(int));
+	attrcookies = ecalloc(num + 1, sizeof(xcb_get_window_attributes_cookie_t));
+	geomcookies = ecalloc(num + 1, sizeof(xcb_get_geometry_cookie_t));
+	transcookies = ecalloc(num + 1, sizeof(xcb_get_property_cookie_t));
+	statecookies = ecalloc(num + 1, sizeof(xcb_get_property_cookie_t));
+
+	for (i = 0; i < num; i++) {
+		attrcookies[i] = xcb_get_window_attributes(xcon, wins[i]);
+		geomcookies[i] = xcb_get_geometry(xcon, wins[i]);
+		transcookies[i] = xcb_get_property(xcon, 0, wins[i], XA_WM_TRANSIENT_FOR, XA_WINDOW, 0, 1);
+		statecookies[i] = xcb_get_property(xcon, 0, wins[i], wmatom[WMState], wmatom[WMState], 0, 2);
+	}
+
+	for (i = 0; i < num; i++) {
+		e = NULL;
+		attr = xcb_get_window_attributes_reply(xcon, attrcookies[i], &e);
+		free(e);
+		e = NULL;
+		geom = xcb_get_geometry_reply(xcon, geomcookies[i], &e);
+		free(e);
+		e = NULL;
+		trans = xcb_get_property_reply(xcon, transcookies[i], &e);
+		free(e);
+		e = NULL;
+		wmstate = xcb_get_property_reply(xcon, statecookies[i], &e);
+		free(e);
+
+		if (attr && geom && !attr->override_redirect) {
+			was[i].x = geom->x;
+			was[i].y = geom->y;
+			was[i].width = geom->width;
+			was[i].height = geom->height;
+			was[i].border_width = geom->border_width;
+			was[i].depth = geom->depth;
+			was[i].map_state = attr->map_state;
+			was[i].override_redirect = attr->override_redirect;
+			candidate[i] = 1;
+			transient[i] = trans && trans->type == XA_WINDOW && trans->format == 32;
+			state = wmstate && wmstate->format == 32 && xcb_get_property_value_length(wmstate) >= 4
+				? *(uint32_t *)xcb_get_property_value(wmstate)
+				: -1;
+			adoptable[i] = (attr->map_state == IsViewable || state == IconicState);
 		}
-		for (i = 0; i < num; i++) { /* now the transients */
-			if (!XGetWindowAttributes(dpy, wins[i], &wa) || wa.override_redirect)
-				continue;
-			if (XGetTransientForHint(dpy, wins[i], &d1)
-			&& (wa.map_state == IsViewable || getstate(wins[i]) == IconicState))
-				manage(wins[i], &wa);
+
+		free(attr);
+		free(geom);
+		free(trans);
+		free(wmstate);
+	}
+
+	/* Transients are managed after the windows they may be transient for. External bars are
+	 * taken over regardless of their map state, as a bar that was hidden is not viewable. */
+	for (i = 0; i < num; i++) {
+		if (!candidate[i] || transient[i])
+			continue;
+		if (mapexternalbar(wins[i])) {
+			adoptable[i] = 0;
+			continue;
 		}
-		XFree(wins);
+		if (!adoptable[i])
+			continue;
+		adoptidx[n] = i;
+		adopt[n++] = wins[i];
 	}
+	for (i = 0; i < num; i++) {
+		if (adoptable[i] && transient[i]) {
+			adoptidx[n] = i;
+			adopt[n++] = wins[i];
+		}
+	}
+
+	prefetchwindows(adopt, n);
+	for (k = 0; k < n; k++)
+		manage(adopt[k], &was[adoptidx[k]]);
 
+	numscanned = n;
 	scanning = 0;
+
+	arrange(NULL);
+	for (m = mons; m; m = m->next)
+		if (m->selws)
+			restack(m->selws);
+
+	free(statecookies);
+	free(transcookies);
+	free(geomcookies);
+	free(attrcookies);
+	free(adoptidx);
+	free(adopt);
+	free(adoptable);
+	free(transient);
+	free(candidate);
+	free(was);
+	XFree(wins);
 }
 
 void
@@ -3494,7 +3903,7 @@ setup(void)
 	sh = DisplayHeight(dpy, screen);
 	root = RootWindow(dpy, screen);
 	xinitvisual();
-	drw = drw_create(dpy, screen, root, sw, sh, visual, depth, cmap);
+	drw = drw_create(dpy, screen, root, 1, 1, visual, depth, cmap);
 
 	enablefunc(functionality);
 	load_config();
@@ -3628,11 +4037,14 @@ seturgent(Client *c, int urg)
 	XFree(wmh);
 }
 
+/* EnterNotify events caused by our own requests (restacking, moving and resizing windows under
+ * the mouse cursor) only arrive after the X server has processed said requests. Rather than
+ * syncing on every call the skipping is deferred until the current event has been handled,
+ * see flushrequests. */
 void
 skipfocusevents(void)
 {
-	XEvent ev;
-	while (XCheckMaskEvent(dpy, EnterWindowMask, &ev)); // skip any new EnterNotify events
+	skipenterpending = 1;
 }
 
 void
@@ -3815,7 +4227,6 @@ togglefloating(const Arg *arg)
 	}
 
 	if (ws) {
-		XSync(dpy, False);
 		drawbar(ws->mon);
 		arrange(ws);
 	}
@@ -3878,8 +4289,13 @@ unmanage(Client *c, int destroyed)
 	if (ISMARKED(c))
 		unmarkclient(c);
 
+	#ifdef HAVE_DBUS
+	ipc_client_removed(c);
+	#endif
 	detach(c);
 	detachstack(c);
+	winindexremove(&clientindex, c->win, c);
+	unindexpid(c);
 	freeicon(c);
 	free(c->name);
 	free(c->alttitle);
@@ -3891,7 +4307,7 @@ unmanage(Client *c, int destroyed)
 		XSetErrorHandler(xerrordummy);
 		XSelectInput(dpy, c->win, NoEventMask);
 		XUngrabButton(dpy, AnyButton, AnyModifier, c->win);
-		XSync(dpy, False);
+		xsync();
 		XSetErrorHandler(xerror);
 		XUngrabServer(dpy);
 	}
@@ -3961,23 +4377,51 @@ unmapnotify(XUnmapEvent *ev)
 
 void
 updateclientlist(void)
+{
+	clientlistpending = 1;
+}
+
+/* Publishes the client lists if they have changed since they were last published. This is
+ * called once per handled event, see flushrequests. */
+void
+writeclientlist(void)
 {
 	Client *c;
 	Workspace *ws;
+	unsigned int i, n = 0;
+
+	if (!clientlistpending)
+		return;
+
+	clientlistpending = 0;
 
-	XDeleteProperty(dpy, root, netatom[NetClientList]);
 	for (ws = workspaces; ws; ws = ws->next)
 		for (c = ws->clients; c; c = c->next)
-			XChangeProperty(dpy, root, netatom[NetClientList],
-				XA_WINDOW, 32, PropModeAppend,
-				(unsigned char *) &(c->win), 1);
+			n++;
 
-	XDeleteProperty(dpy, root, netatom[NetClientListStacking]);
-	for (ws = workspaces; ws; ws = ws->next)
-		for (c = ws->stack; c; c = c->snext)
-			XChangeProperty(dpy, root, netatom[NetClientListStacking],
-				XA_WINDOW, 32, PropModeAppend,
-				(unsigned char *) &(c->win), 1);
+	if (n > clientlistsize) {
+		clientlistsize = n + 64;
+		clientlistbuf = realloc(clientlistbuf, clientlistsize * sizeof(Window));
+		for (i = 0; i < LENGTH(clientlists); i++)
+			clientlists[i] = realloc(clientlists[i], clientlistsize * sizeof(Window));
+		if (!clientlistbuf || !clientlists[0] || !clientlists[1])
+			die("realloc:");
+	}
+
+	for (i = 0; i < LENGTH(clientlists); i++) {
+		n = 0;
+		for (ws = workspaces; ws; ws = ws->next)
+			for (c = (i ? ws->stack : ws->clients); c; c = (i ? c->snext : c->next))
+				clientlistbuf[n++] = c->win;
+
+		if (n == nclientlists[i] && !memcmp(clientlistbuf, clientlists[i], n * sizeof(Window)))
+			continue;
+
+		XChangeProperty(dpy, root, netatom[i ? NetClientListStacking : NetClientList],
+			XA_WINDOW, 32, PropModeReplace, (unsigned char *) clientlistbuf, n);
+		memcpy(clientlists[i], clientlistbuf, n * sizeof(Window));
+		nclientlists[i] = n;
+	}
 }
 
 int
@@ -4103,7 +4547,7 @@ updatesizehints(Client *c)
 	long msize;
 	XSizeHints size;
 
-	if (!XGetWMNormalHints(dpy, c->win, &size, &msize)) {
+	if (!getwmnormalhints(c->win, &size, &msize)) {
 		/* size is uninitialized, ensure that size.flags aren't used */
 		size.flags = PSize;
 	}
@@ -4172,7 +4616,7 @@ updatewmhints(Client *c)
 {
 	XWMHints *wmh;
 
-	if ((wmh = XGetWMHints(dpy, c->win))) {
+	if ((wmh = getwmhints(c->win))) {
 		if (c == selws->sel && wmh->flags & XUrgencyHint) {
 			wmh->flags &= ~XUrgencyHint;
 			XSetWMHints(dpy, c->win, wmh);
@@ -4191,23 +4635,7 @@ updatewmhints(Client *c)
 Client *
 wintoclient(Window w)
 {
-	Workspace *ws;
-	Client *c, *next;
-
-	for (ws = workspaces; ws; ws = ws->next) {
-		for (c = ws->clients; c; c = next) {
-			next = c->next;
-			if (c->win == w)
-				return c;
-			while (c->swallowing) {
-				c = c->swallowing;
-				if (c->win == w)
-					return c;
-			}
-		}
-	}
-
-	return NULL;
+	return winindexget(&clientindex, w);
 }
 
 Monitor *
@@ -4215,15 +4643,12 @@ wintomon(Window w)
 {
 	int x, y;
 	Client *c;
-	Monitor *m;
 	Bar *bar;
 
 	if (w == root && getrootptr(&x, &y))
 		return recttomon(x, y, 1, 1);
-	for (m = mons; m; m = m->next)
-		for (bar = m->bar; bar; bar = bar->next)
-			if (w == bar->win)
-				return m;
+	if ((bar = wintobar(w)))
+		return bar->mon;
 	if ((c = wintoclient(w)))
 		return c->ws->mon;
 
@@ -4270,6 +4695,15 @@ xerror(Display *dpy, XErrorEvent *ee)
 	return xerrorxlib(dpy, ee); /* may call exit */
 }
 
+/* Makes a round-trip to the X server, counted so that the number of syncs per handled event can
+ * be inspected via the get_sync_stats IPC command. */
+void
+xsync(void)
+{
+	XSync(dpy, False);
+	num_syncs++;
+}
+
 int
 xerrordummy(Display *dpy, XErrorEvent *ee)
 {
@@ -4346,10 +4780,14 @@ main(int argc, char *argv[])
 		die("pledge");
 #endif /* __OpenBSD__ */
 	scan();
+	flushrequests();
+	logrestart();
 	run();
 	cleanup();
 	XCloseDisplay(dpy);
-	if (restartwm)
+	if (restartwm) {
+		setrestarttime();
 		execvp(argv[0], argv);
+	}
 	return EXIT_SUCCESS;
 }
@@ -22,6 +22,16 @@ usage(FILE *stream)
 		"  get_settings                    Get list of settings\n\n"
 		"  get_commands                    Get list of commands\n\n"
 		"  get_systray_windows             Get list of system tray windows\n\n"
+		"  get_sync_stats                  Get the number of X server round-trips per handled event\n\n"
+		"  get_pixmap_stats                Get the X server pixmap memory held for bars and previews\n\n"
+		"  get_profile                     Get X requests, round-trips, latency histograms and percentiles\n"
+		"                                  per event type and command, and the slowest events handled,\n"
+		"                                  requires the Profiling functionality to be enabled\n\n"
+		"  reset_profile                   Clear the profile gathered so far\n\n"
+		"  subscribe <events>              Print a snapshot of the monitors, workspaces, clients and\n"
+		"                                  focus followed by an event for every change, one per line.\n"
+		"                                  Events is a comma separated list of workspace, focus,\n"
+		"                                  client, layout and monitor, or all\n\n"
 		"  help                            Display this message\n\n"
 		"Options:\n"
 		"  -q, --ignore-reply              Don't print reply messages from run_command.\n"
@@ -59,11 +69,14 @@ void
 parseargs(int argc, char *argv[])
 {
 	int i, a, scanned, arg_int;
+	int32_t arg_int32;
 	unsigned int arg_uint;
 	double arg_double;
 	DBusMessage *msg;
+	IPCBuffer request = {0};
 	IPCCommand *command = NULL;
 	int wait_for_reply = 1;
+	int follow;
 	char dbus_name[256];
 	prepare_dbus_name(dbus_name, dbus_base_name);
 	char *dbus_path = "/wm/dusk";
@@ -103,11 +116,13 @@ parseargs(int argc, char *argv[])
 
 		if (command != NULL) {
 			msg = create_dbus_message(dbus_name, dbus_path, dbus_interface, command->name);
+			ipc_append(&request, command->name, strlen(command->name) + 1);
 
 			for (a = 0, i++; i < argc && a < command->argc; i++, a++) {
 				switch (command->args[a]) {
 				case DBUS_TYPE_STRING:
 					add_string_argument(msg, argv[i]);
+					ipc_append(&request, argv[i], strlen(argv[i]) + 1);
 					break;
 				case DBUS_TYPE_DOUBLE:
 					scanned = sscanf(argv[i], "%lf", &arg_double);
@@ -117,6 +132,7 @@ parseargs(int argc, char *argv[])
 						exit(1);
 					}
 					add_double_argument(msg, arg_double);
+					ipc_append(&request, &arg_double, sizeof(arg_double));
 					break;
 				case DBUS_TYPE_INT32:
 					/* If the argument starts with 0x then try to parse it as hex instead of integer. */
@@ -133,6 +149,8 @@ parseargs(int argc, char *argv[])
 					}
 
 					add_int_argument(msg, arg_int);
+					arg_int32 = arg_int;
+					ipc_append(&request, &arg_int32, sizeof(arg_int32));
 					break;
 				}
 			}
@@ -144,8 +162,26 @@ parseargs(int argc, char *argv[])
 				exit(1);
 			}
 
-			send_dbus_message(msg, wait_for_reply);
+			/* Events are only sent over the IPC socket */
+			follow = !strcmp(command->name, "subscribe");
+			if (follow && !send_ipc_message(dbus_name, &request, 1, 1)) {
+				fprintf(stderr, "Error: Command %s requires the IPC socket in $XDG_RUNTIME_DIR\n", command->name);
+				dbus_message_unref(msg);
+				exit(1);
+			}
+
+			/* The IPC socket is preferred, the session bus is only connected to if dusk can
+			 * not be reached that way */
+			if (!follow && !send_ipc_message(dbus_name, &request, wait_for_reply, 0)) {
+				init_dbus();
+				if (!dbus_init) {
+					dbus_message_unref(msg);
+					exit(1);
+				}
+				send_dbus_message(msg, wait_for_reply);
+			}
 			dbus_message_unref(msg);
+			free(request.data);
 			break;
 		}
 	}
@@ -154,8 +190,8 @@ parseargs(int argc, char *argv[])
 int
 main(int argc, char *argv[])
 {
-	init_dbus();
 	parseargs(argc, argv);
-	cleanup_dbus();
+	if (dbus_init)
+		cleanup_dbus();
 	return 0;
 }
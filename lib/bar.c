@@ -119,23 +119,24 @@ createbar(const BarDef *def, Monitor *m)
 	bar->p = ecalloc(num_barrules, sizeof(int));
 	bar->sscheme = ecalloc(num_barrules, sizeof(int));
 	bar->escheme = ecalloc(num_barrules, sizeof(int));
+	bar->moddirty = ecalloc(num_barrules, sizeof(char));
+	bar->mods = ecalloc(num_barrules, sizeof(BarModule));
+	bar->invalid = 1;
+	bar->drawnscheme = -1;
 
 	m->bar = bar;
 }
 
+/* Bars are not drawn straight away. Callers mark the bars (or bar modules) that need to be
+ * redrawn and flushbars() renders each of them once before the event loop waits for more
+ * events, so that several changes in response to the same event result in a single redraw. */
 void
 drawbar(Monitor *m)
 {
 	Bar *bar;
-	Workspace *ws;
 
-	if (m->showbar) {
-		for (ws = nextvismonws(m, workspaces); ws; ws = nextvismonws(m, ws->next))
-			if (hasfullscreen(ws))
-				return;
-		for (bar = m->bar; bar; bar = bar->next)
-			drawbarwin(bar);
-	}
+	for (bar = m->bar; bar; bar = bar->next)
+		bar->dirty |= BarDirty;
 }
 
 void
@@ -149,13 +150,132 @@ drawbars(void)
 void
 drawbarwin(Bar *bar)
 {
-	if (!bar || !bar->win || bar->external)
+	if (bar)
+		bar->dirty |= BarDirtyAlways;
+}
+
+void
+drawbarmodule(const BarRule *br, int r)
+{
+	Monitor *m;
+	Bar *bar;
+
+	for (m = mons; m; m = m->next) {
+		if ((br->monitor > -1 && br->monitor != m->num) || !m->showbar)
+			continue;
+		for (bar = m->bar; bar; bar = bar->next) {
+			if ((br->bar > -1 && br->bar != bar->idx) || bar->external)
+				continue;
+			bar->moddirty[r] = 1;
+			bar->dirty |= BarDirtyModule;
+		}
+	}
+}
+
+/* The back buffer holds the complete bar, so the window content can be restored as-is unless
+ * the buffer has yet to be drawn in full */
+void
+exposebar(Bar *bar)
+{
+	if (!bar || bar->external)
+		return;
+
+	if (!bar->buf || bar->invalid) {
+		bar->invalid = 1;
+		bar->dirty |= BarDirtyAlways;
+		return;
+	}
+
+	drw_setbuf(drw, bar->buf);
+	drw_map(drw, bar->win, 0, 0, bar->bw, bar->bh);
+}
+
+void
+flushbars(void)
+{
+	Monitor *m;
+	Bar *bar;
+	Workspace *ws;
+	ProfileMark pm;
+	int r, pass, fullscreen, dirty;
+
+	for (m = mons; m; m = m->next) {
+		for (bar = m->bar; bar && !bar->dirty; bar = bar->next);
+		if (bar)
+			break;
+	}
+
+	/* Nothing to draw */
+	if (!m)
+		return;
+
+	profbegin(&pm);
+
+	/* Drawing a bar can cause other bars to be marked, e.g. when it is shown or hidden */
+	for (pass = 0; pass < 3; pass++) {
+		dirty = 0;
+		for (m = mons; m; m = m->next) {
+			for (bar = m->bar; bar && !bar->dirty; bar = bar->next);
+			if (!bar)
+				continue;
+
+			dirty = 1;
+			for (fullscreen = 0, ws = nextvismonws(m, workspaces); ws && !fullscreen; ws = nextvismonws(m, ws->next))
+				fullscreen = hasfullscreen(ws);
+
+			for (bar = m->bar; bar; bar = bar->next) {
+				if (!bar->dirty)
+					continue;
+				if ((bar->dirty & BarDirtyAlways) || ((bar->dirty & BarDirty) && m->showbar && !fullscreen)) {
+					bar->dirty = 0;
+					memset(bar->moddirty, 0, num_barrules);
+					renderbar(bar);
+					continue;
+				}
+				if ((bar->dirty & BarDirtyModule) && m->showbar) {
+					bar->dirty = 0;
+					for (r = 0; r < num_barrules; r++) {
+						if (!bar->moddirty[r])
+							continue;
+						bar->moddirty[r] = 0;
+						renderbarmodule(bar, r);
+					}
+					continue;
+				}
+				bar->dirty = 0;
+				memset(bar->moddirty, 0, num_barrules);
+			}
+		}
+		if (!dirty)
+			break;
+	}
+
+	profend(&pm, profilesection(ProfFlushBars));
+}
+
+/* Modules are retained in the back buffer of the bar between redraws. Each module has a
+ * fingerprint of the content it was drawn with and only the modules whose fingerprint or position
+ * changed are drawn again, after which only the affected areas are copied to the bar window. The
+ * whole bar is redrawn when the buffer content is lost (e.g. when the bar is resized), or when
+ * the bar scheme changes. */
+void
+renderbar(Bar *bar)
+{
+	if (!bar || !bar->win || !bar->buf || bar->external)
 		return;
 
-	int r, w, mw, total_drawn = 0, idx;
+	int r, i, w, mw, total_drawn = 0, idx, full, added, ndamage = 0;
 	int rx, lx, rw, lw; // bar size, split between left and right if a center module is added
 	const BarRule *br;
+	BarModule *mod;
+	BarArg *args, *a;
+	XRectangle *damage, *d;
+	uint64_t fp;
+	char *changed;
 	Monitor *lastmon;
+	ProfileMark pm;
+
+	profbegin(&pm);
 
 	if (enabled(BarActiveGroupBorderColor) && bar->mon->selws)
 		bar->scheme = clientscheme(bar->mon->selws->sel, bar->mon->selws->sel);
@@ -164,7 +284,12 @@ drawbarwin(Bar *bar)
 	else
 		bar->scheme = SchemeNorm;
 
-	if (bar->borderpx) {
+	drw_setbuf(drw, bar->buf);
+	full = bar->invalid || !bar->showbar || bar->scheme != bar->drawnscheme;
+	bar->invalid = 0;
+	bar->drawnscheme = bar->scheme;
+
+	if (full && bar->borderpx) {
 		idx = (enabled(BarBorderColBg) ? ColBg : ColBorder);
 		XSetForeground(drw->dpy, drw->gc, scheme[bar->scheme][idx].pixel);
 		XFillRectangle(drw->dpy, drw->drawable, drw->gc, 0, 0, bar->bw, bar->bh);
@@ -178,9 +303,16 @@ drawbarwin(Bar *bar)
 
 	for (lastmon = mons; lastmon && lastmon->next; lastmon = lastmon->next);
 
-	drw_setscheme(drw, scheme[SchemeNorm]);
-	drw_rect(drw, lx, bar->borderpx, lw, bar->bh - 2 * bar->borderpx, 1, 1);
+	if (full) {
+		drw_setscheme(drw, scheme[SchemeNorm]);
+		drw_rect(drw, lx, bar->borderpx, lw, bar->bh - 2 * bar->borderpx, 1, 1);
+	}
+
+	args = ecalloc(num_barrules, sizeof(BarArg));
+	changed = ecalloc(num_barrules, sizeof(char));
+	damage = ecalloc(2 * num_barrules, sizeof(XRectangle));
 
+	/* Work out the size and position of all modules */
 	for (r = 0; r < num_barrules; r++) {
 		br = &_cfg_barrules[r];
 		bar->s[r] = 0;
@@ -334,19 +466,96 @@ drawbarwin(Bar *bar)
 			barg.h = bar->bh - 2 * bar->borderpx;
 		}
 
-		if (br->drawfunc && br->drawfunc != draw_powerline) {
-			total_drawn += br->drawfunc(bar, &barg);
-			bar->sscheme[r] = (barg.firstscheme != -1 ? barg.firstscheme : barg.scheme);
-			bar->escheme[r] = (barg.lastscheme != -1 ? barg.lastscheme : barg.scheme);
+		args[r] = barg;
+	}
+
+	/* Work out which modules need to be redrawn, the areas they were drawn to previously and
+	 * the areas they are to be drawn to make up the damage */
+	for (r = 0; r < num_barrules; r++) {
+		br = &_cfg_barrules[r];
+		mod = &bar->mods[r];
+		a = &args[r];
+		if (!bar->s[r] && !mod->shown)
+			continue;
+		if (full || !bar->s[r] || !mod->shown
+				|| mod->x != a->x || mod->y != a->y || mod->w != a->w || mod->h != a->h) {
+			changed[r] = 1;
+		} else if (br->drawfunc != draw_powerline) {
+			fp = barmodulefingerprint(bar, br, a);
+			changed[r] = (!fp || fp != mod->fingerprint);
+		} else {
+			changed[r] = (mod->fingerprint != barpowerlinefingerprint(bar, br, r));
 		}
 	}
 
+	/* Modules overlapping a damaged area must be redrawn as well */
+	do {
+		for (ndamage = 0, r = 0; r < num_barrules; r++) {
+			if (!changed[r])
+				continue;
+			mod = &bar->mods[r];
+			if (mod->shown && mod->w > 0 && mod->h > 0)
+				damage[ndamage++] = (XRectangle){ mod->x, mod->y, mod->w, mod->h };
+			if (bar->s[r] && args[r].w > 0 && args[r].h > 0)
+				damage[ndamage++] = (XRectangle){ args[r].x, args[r].y, args[r].w, args[r].h };
+		}
+
+		for (added = 0, r = 0; r < num_barrules && !full; r++) {
+			if (changed[r] || !bar->s[r])
+				continue;
+			a = &args[r];
+			for (i = 0; i < ndamage; i++) {
+				d = &damage[i];
+				if (a->x < d->x + d->width && d->x < a->x + a->w && a->y < d->y + d->height && d->y < a->y + a->h) {
+					changed[r] = added = 1;
+					break;
+				}
+			}
+		}
+	} while (added);
+
+	if (!full) {
+		drw_setscheme(drw, scheme[SchemeNorm]);
+		for (i = 0; i < ndamage; i++)
+			drw_rect(drw, damage[i].x, damage[i].y, damage[i].width, damage[i].height, 1, 1);
+	}
+
+	for (r = 0; r < num_barrules; r++) {
+		br = &_cfg_barrules[r];
+		mod = &bar->mods[r];
+		a = &args[r];
+		if (changed[r]) {
+			mod->shown = bar->s[r] != 0;
+			mod->x = a->x;
+			mod->y = a->y;
+			mod->w = a->w;
+			mod->h = a->h;
+			mod->drawn = 0;
+			mod->fingerprint = 0;
+			if (mod->shown && br->drawfunc && br->drawfunc != draw_powerline) {
+				drw_setscheme(drw, scheme[a->scheme]);
+				mod->fingerprint = barmodulefingerprint(bar, br, a);
+				mod->drawn = br->drawfunc(bar, a);
+				bar->sscheme[r] = (a->firstscheme != -1 ? a->firstscheme : a->scheme);
+				bar->escheme[r] = (a->lastscheme != -1 ? a->lastscheme : a->scheme);
+			}
+		}
+		total_drawn += mod->drawn;
+	}
+
 	/* Draw powerline separators */
 	for (r = 0; r < num_barrules; r++) {
 		br = &_cfg_barrules[r];
+		mod = &bar->mods[r];
 		if (!bar->s[r] || br->drawfunc != draw_powerline)
 			continue;
 
+		/* The schemes of the neighbouring modules are only known once those have been drawn */
+		fp = barpowerlinefingerprint(bar, br, r);
+		if (!changed[r] && fp == mod->fingerprint)
+			continue;
+		mod->fingerprint = fp;
+
 		barg.lpad = br->lpad;
 		barg.rpad = br->rpad;
 		barg.value = br->value;
@@ -358,6 +567,13 @@ drawbarwin(Bar *bar)
 		barg.h = bar->bh - 2 * bar->borderpx;
 		barg.w = bar->s[r];
 
+		if (!changed[r]) {
+			a = &args[r];
+			drw_setscheme(drw, scheme[SchemeNorm]);
+			drw_rect(drw, a->x, a->y, a->w, a->h, 1, 1);
+			damage[ndamage++] = (XRectangle){ a->x, a->y, a->w, a->h };
+		}
+
 		br->drawfunc(bar, &barg);
 	}
 
@@ -374,54 +590,188 @@ drawbarwin(Bar *bar)
 		drw_map(drw, bar->win, 0, 0, bar->bw, bar->bh);
 		setworkspaceareasformon(bar->mon);
 		arrangemon(bar->mon);
-	} else {
+	} else if (full) {
 		drw_map(drw, bar->win, 0, 0, bar->bw, bar->bh);
+	} else {
+		for (i = 0; i < ndamage; i++)
+			drw_map(drw, bar->win, damage[i].x, damage[i].y, damage[i].width, damage[i].height);
 	}
+
+	free(args);
+	free(changed);
+	free(damage);
+	profend(&pm, profilesection(ProfRenderBar));
 }
 
 void
-drawbarmodule(const BarRule *br, int r)
+renderbarmodule(Bar *bar, int r)
 {
-	Monitor *m;
-	Bar *bar;
+	const BarRule *br = &_cfg_barrules[r];
+	BarModule *mod = &bar->mods[r];
+	uint64_t fp;
 	BarArg barg = { 0 };
 	barg.lpad = br->lpad;
 	barg.rpad = br->rpad;
 	barg.value = br->value;
 	barg.scheme = (br->scheme > -1 ? br->scheme : SchemeNorm);
 
+	if (bar->vert) {
+		barg.x = bar->borderpx + 5;
+		barg.y = bar->p[r];
+		barg.h = bar->s[r] + barg.lpad + barg.rpad;
+		barg.w = bar->bw - 2 * bar->borderpx;
+	} else {
+		barg.y = bar->borderpx;
+		barg.x = bar->p[r];
+		barg.w = bar->s[r] + barg.lpad + barg.rpad;
+		barg.h = bar->bh - 2 * bar->borderpx;
+	}
+
+	/* Optimisation, if the bar module size has not changed then we can just
+	   update the designated part of the bar rather than drawing the entire
+	   bar, otherwise only update the bars that have this module. If the
+	   content of the module has not changed either then there is nothing to
+	   draw at all. */
+	if (bar->invalid || !bar->buf || bar->s[r] != br->sizefunc(bar, &barg)) {
+		renderbar(bar);
+		return;
+	}
+
+	if (!bar->s[r])
+		return;
+
+	fp = barmodulefingerprint(bar, br, &barg);
+	if (fp && fp == mod->fingerprint)
+		return;
+
+	mod->fingerprint = fp;
+	drw_setbuf(drw, bar->buf);
+	drw_setscheme(drw, scheme[barg.scheme]);
+	br->drawfunc(bar, &barg);
+	drw_map(drw, bar->win, barg.x, barg.y, barg.w, barg.h);
+}
+
+/* Marks the content of all bar windows as lost so that the bars are drawn again in full, e.g.
+ * following a change of colours or of functionality that affects how modules are drawn. */
+void
+invalidatebars(void)
+{
+	Monitor *m;
+	Bar *bar;
+
 	for (m = mons; m; m = m->next) {
-		if ((br->monitor > -1 && br->monitor != m->num) || !m->showbar)
-			continue;
 		for (bar = m->bar; bar; bar = bar->next) {
-			if ((br->bar > -1 && br->bar != bar->idx) || bar->external)
-				continue;
+			bar->invalid = 1;
+			bar->dirty |= BarDirty;
+		}
+	}
+}
 
-			if (bar->vert) {
-				barg.x = bar->borderpx + 5;
-				barg.y = bar->p[r];
-				barg.h = bar->s[r] + barg.lpad + barg.rpad;
-				barg.w = bar->bw - 2 * bar->borderpx;
-			} else {
-				barg.y = bar->borderpx;
-				barg.x = bar->p[r];
-				barg.w = bar->s[r] + barg.lpad + barg.rpad;
-				barg.h = bar->bh - 2 * bar->borderpx;
-			}
+uint64_t
+fphash(uint64_t h, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	size_t i;
 
-			/* Optimisation, if the bar module size has not changed then we can just
-			   update the designated part of the bar rather than drawing the entire
-			   bar, otherwise only update the bars that have this module. */
-			if (bar->s[r] == br->sizefunc(bar, &barg)) {
-				if (!bar->s[r])
-					continue;
-				br->drawfunc(bar, &barg);
-				drw_map(drw, bar->win, barg.x, barg.y, barg.w, barg.h);
-			} else {
-				drawbarwin(bar);
+	/* FNV-1a */
+	for (i = 0; i < len; i++) {
+		h ^= p[i];
+		h *= 1099511628211ULL;
+	}
+
+	return h;
+}
+
+uint64_t
+fpstring(uint64_t h, const char *s)
+{
+	return s ? fphash(h, s, strlen(s) + 1) : fphash(h, &s, sizeof s);
+}
+
+/* Returns a fingerprint of the state that the given module draws, or 0 if the module is to be
+ * redrawn every time. Two equal fingerprints mean that drawing the module again in the same
+ * place would produce the same result. */
+uint64_t
+barmodulefingerprint(Bar *bar, const BarRule *br, BarArg *a)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	int selected = (bar->mon == selmon);
+	Workspace *ws;
+	Client *c;
+
+	h = fphash(h, &a->scheme, sizeof a->scheme);
+	h = fphash(h, &a->value, sizeof a->value);
+	h = fphash(h, &bar->scheme, sizeof bar->scheme);
+	h = fphash(h, &selected, sizeof selected);
+	h = fphash(h, &selws, sizeof selws);
+
+	if (br->drawfunc == draw_status) {
+		h = fpstring(h, rawstatustext[a->value]);
+	} else if (br->drawfunc == draw_ltsymbol) {
+		h = fphash(h, &bar->mon->selws->visible, sizeof(int));
+		h = fpstring(h, bar->mon->selws->ltsymbol);
+	} else if (br->drawfunc == draw_workspaces) {
+		for (ws = workspaces; ws; ws = ws->next) {
+			if (ws->mon != bar->mon || ws == stickyws)
+				continue;
+			h = fphash(h, &ws, sizeof ws);
+			h = fphash(h, &ws->visible, sizeof ws->visible);
+			h = fphash(h, &ws->pinned, sizeof ws->pinned);
+			h = fphash(h, &ws->mon->selws, sizeof ws->mon->selws);
+			h = fphash(h, ws->scheme, sizeof ws->scheme);
+			h = fpstring(h, wsicon(ws));
+			for (c = ws->clients; c; c = c->next)
+				h = fphash(h, &c->flags, sizeof c->flags);
+			if ((c = getworkspacelabelclient(ws))) {
+				h = fpstring(h, c->label);
+				h = fphash(h, &c->icon, sizeof c->icon);
+				h = fphash(h, &c->icw, sizeof c->icw);
 			}
 		}
+	} else if (br->drawfunc == draw_flexwintitle
+			|| br->drawfunc == draw_wintitle_floating
+			|| br->drawfunc == draw_wintitle_hidden
+			|| br->drawfunc == draw_wintitle_sticky
+			|| br->drawfunc == draw_wintitle_single) {
+		for (ws = workspaces; ws; ws = ws->next) {
+			if (ws->mon != bar->mon && ws != stickyws)
+				continue;
+			h = fphash(h, &ws, sizeof ws);
+			h = fphash(h, &ws->visible, sizeof ws->visible);
+			h = fphash(h, &ws->sel, sizeof ws->sel);
+			h = fphash(h, &ws->layout, sizeof ws->layout);
+			h = fphash(h, ws->ltaxis, sizeof ws->ltaxis);
+			h = fphash(h, &ws->nmaster, sizeof ws->nmaster);
+			h = fphash(h, &ws->nstack, sizeof ws->nstack);
+			if (!ws->visible)
+				continue;
+			for (c = ws->clients; c; c = c->next) {
+				h = fphash(h, &c, sizeof c);
+				h = fphash(h, &c->flags, sizeof c->flags);
+				h = fphash(h, &c->area, sizeof c->area);
+				h = fphash(h, &c->scheme, sizeof c->scheme);
+				h = fphash(h, &c->icon, sizeof c->icon);
+				h = fphash(h, &c->icw, sizeof c->icw);
+				h = fpstring(h, c->name);
+				h = fpstring(h, c->alttitle);
+				h = fpstring(h, c->label);
+			}
+		}
+	} else {
+		return 0;
 	}
+
+	return h ? h : 1;
+}
+
+uint64_t
+barpowerlinefingerprint(Bar *bar, const BarRule *br, int r)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	int v[4] = { br->value, br->scheme, schemeleftof(bar, r), schemerightof(bar, r) };
+
+	h = fphash(h, v, sizeof v);
+	return h ? h : 1;
 }
 
 void
@@ -447,6 +797,8 @@ setbarpos(Bar *bar)
 	int x_pad = (enabled(BarPadding) && !bar->external ? sidepad : 0);
 	Monitor *m = bar->mon;
 
+	bar->invalid = 1;
+
 	switch (sscanf(bar->barpos, "%f%c %f%c %f%c %f%c", &x, &xCh, &y, &yCh, &w, &wCh, &h, &hCh)) {
 	case 8:
 		// all good
@@ -494,6 +846,15 @@ setbarpos(Bar *bar)
 		if (y >= 0)
 			bar->by = m->my + y;
 	}
+
+	if (bar->external) {
+		drw_buf_free(drw, bar->buf);
+		bar->buf = NULL;
+	} else if (bar->buf) {
+		drw_buf_resize(drw, bar->buf, bar->bw, bar->bh);
+	} else {
+		bar->buf = drw_buf_create(drw, bar->bw, bar->bh);
+	}
 }
 
 void
@@ -581,12 +942,14 @@ removebar(Bar *bar)
 		else
 			continue;
 
+		winindexremove(&barindex, bar->win, bar);
 		if (!bar->external) {
 			XUnmapWindow(dpy, bar->win);
 			XDestroyWindow(dpy, bar->win);
 		}
 		if (systray && bar == systray->bar)
 			systray->bar = NULL;
+		drw_buf_free(drw, bar->buf);
 		free(bar);
 		break;
 	}
@@ -617,6 +980,7 @@ updatebars(void)
 				XDefineCursor(dpy, bar->win, cursor[CurNormal]->cursor);
 				XSetClassHint(dpy, bar->win, &ch);
 				XMapWindow(dpy, bar->win);
+				winindexadd(&barindex, bar->win, bar);
 			}
 		}
 	}
@@ -667,6 +1031,7 @@ teardownbars(Monitor *m)
 	for (bar = m->bar; bar; bar = next) {
 		next = bar->next;
 
+		winindexremove(&barindex, bar->win, bar);
 		if (!bar->external) {
 			XUnmapWindow(dpy, bar->win);
 			XDestroyWindow(dpy, bar->win);
@@ -679,6 +1044,9 @@ teardownbars(Monitor *m)
 		free(bar->p);
 		free(bar->sscheme);
 		free(bar->escheme);
+		free(bar->moddirty);
+		free(bar->mods);
+		drw_buf_free(drw, bar->buf);
 		free(bar);
 	}
 
@@ -739,13 +1107,7 @@ togglecompact(const Arg *arg)
 Bar *
 wintobar(Window win)
 {
-	Monitor *m;
-	Bar *bar;
-	for (m = mons; m; m = m->next)
-		for (bar = m->bar; bar; bar = bar->next)
-			if (bar->win == win)
-				return bar;
-	return NULL;
+	return winindexget(&barindex, win);
 }
 
 Bar *
@@ -758,11 +1120,13 @@ mapexternalbar(Window win)
 		for (bar = m->bar; bar; bar = bar->next) {
 			if (matchextbar(bar, win)) {
 				if (bar->win && bar->win != win) {
+					winindexremove(&barindex, bar->win, bar);
 					XUnmapWindow(dpy, bar->win);
 					XDestroyWindow(dpy, bar->win);
 				}
 
 				bar->win = win;
+				winindexadd(&barindex, win, bar);
 				bar->showbar = 1;
 				bar->external = 1;
 				bar->borderpx = 0;
@@ -20,6 +20,19 @@ enum {
 	BAR_ALIGN_LAST
 }; /* bar alignment */
 
+enum {
+	BarDirty = 1 << 0,       /* redraw the bar unless a workspace on the monitor is fullscreen */
+	BarDirtyAlways = 1 << 1, /* redraw the bar regardless */
+	BarDirtyModule = 1 << 2, /* one or more modules are to be redrawn, see moddirty */
+}; /* bar dirty flags */
+
+typedef struct {
+	uint64_t fingerprint; /* content the module was last drawn with, 0 to always redraw */
+	int x, y, w, h;       /* area the module was last drawn to */
+	int shown;
+	int drawn;            /* return value of the module's draw function */
+} BarModule;
+
 typedef struct BarDef BarDef;
 struct BarDef {
 	int monitor;
@@ -51,6 +64,12 @@ struct Bar {
 	int *p; // x/y position, array length == ^
 	int *sscheme; // start scheme
 	int *escheme; // end scheme
+	int dirty; // BarDirty flags, the bar is redrawn by flushbars
+	char *moddirty; // modules to be redrawn by flushbars, array length == barrules
+	BarModule *mods; // retained module state, array length == barrules
+	int invalid; // the bar window content is lost and all modules are to be redrawn
+	int drawnscheme; // the bar scheme the bar background was last drawn with
+	DrwBuf *buf; // back buffer the bar is drawn to, sized to the bar geometry
 };
 
 typedef struct {
@@ -92,6 +111,15 @@ static void drawbar(Monitor *m);
 static void drawbars(void);
 static void drawbarwin(Bar *bar);
 static void drawbarmodule(const BarRule *br, int r);
+static void exposebar(Bar *bar);
+static void flushbars(void);
+static void invalidatebars(void);
+static uint64_t barmodulefingerprint(Bar *bar, const BarRule *br, BarArg *a);
+static uint64_t barpowerlinefingerprint(Bar *bar, const BarRule *br, int r);
+static uint64_t fphash(uint64_t h, const void *data, size_t len);
+static uint64_t fpstring(uint64_t h, const char *s);
+static void renderbar(Bar *bar);
+static void renderbarmodule(Bar *bar, int r);
 static void updatebarpos(Monitor *m);
 static void updatebars(void);
 static void recreatebar(Bar *bar);
@@ -25,7 +25,7 @@ static ImageBuffer imagebuffer[30] = {0};
 int
 size_status(Bar *bar, BarArg *a)
 {
-	return (bar->vert ? bh : status2dtextlength(rawstatustext[a->value]));
+	return (bar->vert ? bh : size2dtext(&statuslists[a->value]));
 }
 
 int
@@ -38,40 +38,74 @@ click_status(Bar *bar, Arg *arg, BarArg *a)
 int
 draw_status(Bar *bar, BarArg *a)
 {
-	return drw_2dtext(drw, a->x, a->y, a->w, a->h, a->lpad, rawstatustext[a->value], 0, 1, a->scheme);
+	return replay2dtext(&statuslists[a->value], drw, a->x, a->y, a->w, a->h, a->lpad, 0, 1, a->scheme);
 }
 
 int
 drw_2dtext(Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int lpad, char *text2d, int invert, int drawbg, int defscheme)
 {
+	int ret;
+	Status2dList list = {0};
+
 	if ((!w && drawbg) || text2d == NULL)
 		return 0;
 
-	int i, j, caret, tw, dx = x, stored_dx = 0, stored_mw = 0, len, mw = w - lpad;
-	int rx, ry, rw, rh;
-	int fillbg = drawbg;
+	compile2dtext(&list, text2d);
+	ret = replay2dtext(&list, drw, x, y, w, h, lpad, invert, drawbg, defscheme);
+	free2dtext(&list);
+	free(list.ops);
+
+	return ret;
+}
+
+Status2dOp *
+add2dop(Status2dList *list, int type, int first)
+{
+	Status2dOp *op;
+
+	if (list->count == list->size) {
+		list->size = list->size ? list->size * 2 : 16;
+		list->ops = realloc(list->ops, list->size * sizeof(Status2dOp));
+		if (!list->ops)
+			die("realloc:");
+	}
+
+	op = &list->ops[list->count++];
+	memset(op, 0, sizeof(Status2dOp));
+	op->type = type;
+	op->first = first;
+	return op;
+}
+
+void
+add2dtextrun(Status2dList *list, const char *text)
+{
+	Status2dOp *op = add2dop(list, S2dText, 0);
+	op->str = strdup(text);
+	op->w = TEXTW(text);
+}
+
+/* Parses the status2d markup of the given text into a list of drawing operations that can be
+ * replayed by size2dtext and replay2dtext without having to parse the text again. */
+void
+compile2dtext(Status2dList *list, char *text2d)
+{
+	int i, j, caret, len;
 	short isCode = 0;
 	char *text = {0};
 	char *p = {0};
-	Image *image;
-	Clr oldbg = scheme[defscheme][ColFg];
-	Clr oldfg = scheme[defscheme][ColBg];
+	Status2dOp *op;
+
+	free2dtext(list);
+	if (text2d == NULL)
+		return;
+
 	len = sizeof(char) * (strlen(text2d) + 1);
 	text = (char*) ecalloc(1, len);
 	p = text;
 
 	strlcpy(text, text2d, len);
 
-	if (drawbg) {
-		drw_setscheme(drw, scheme[defscheme]);
-		drw_rect(drw, x, y, w, h, 1, 1);
-	}
-
-	dx += lpad;
-	drw_setscheme(drw, scheme[SchemeLast]);
-	drw->scheme[ColFg] = scheme[defscheme][ColFg];
-	drw->scheme[ColBg] = scheme[defscheme][ColBg];
-
 	/* process status text */
 	i = -1;
 
@@ -82,104 +116,88 @@ drw_2dtext(Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int
 
 			caret = i; // track where the last caret (^) character was, in case we need to abort
 			text[caret] = '\0';
-			tw = textw_clamp(text, mw);
-
-			if (tw) {
-				drw_text(drw, dx, y, tw, bh, 0, text, invert, fillbg);
-				dx += tw;
-				mw -= tw;
-			}
+			add2dtextrun(list, text);
 
 			/* process code */
 			while (text[++i] != '^') {
 				if (text[i] == '\0') {
 					goto abort;
-				} else if (text[i] == 'c') {
+				} else if (text[i] == 'c' || text[i] == 'b') {
 					char buf[8];
 					if (i + 7 > len)
 						goto abort;
 					memcpy(buf, (char*)text+i+1, 7);
 					buf[7] = '\0';
-					drw_clr_create(drw, &drw->scheme[ColFg], buf, enabled(Status2DNoAlpha) ? 0xff : default_alphas[ColFg]);
-					i += 7;
-				} else if (text[i] == 'b') {
-					char buf[8];
-					if (i + 7 > len)
-						goto abort;
-					memcpy(buf, (char*)text+i+1, 7);
-					buf[7] = '\0';
-					drw_clr_create(drw, &drw->scheme[ColBg], buf, enabled(Status2DNoAlpha) ? 0xff : default_alphas[ColBg]);
+					if (text[i] == 'c') {
+						op = add2dop(list, S2dFg, i == caret + 1);
+						drw_clr_create(drw, &op->clr, buf, enabled(Status2DNoAlpha) ? 0xff : default_alphas[ColFg]);
+					} else {
+						op = add2dop(list, S2dBg, i == caret + 1);
+						drw_clr_create(drw, &op->clr, buf, enabled(Status2DNoAlpha) ? 0xff : default_alphas[ColBg]);
+					}
 					i += 7;
 				} else if (text[i] == 'C') {
+					op = add2dop(list, S2dFg, i == caret + 1);
 					int c = atoi(text + ++i) % 16;
-					drw_clr_create(drw, &drw->scheme[ColFg], termcolor[c], enabled(Status2DNoAlpha) ? 0xff : default_alphas[ColFg]);
+					drw_clr_create(drw, &op->clr, termcolor[c], enabled(Status2DNoAlpha) ? 0xff : default_alphas[ColFg]);
 				} else if (text[i] == 'B') {
+					op = add2dop(list, S2dBg, i == caret + 1);
 					int c = atoi(text + ++i) % 16;
-					drw_clr_create(drw, &drw->scheme[ColBg], termcolor[c], enabled(Status2DNoAlpha) ? 0xff : default_alphas[ColBg]);
+					drw_clr_create(drw, &op->clr, termcolor[c], enabled(Status2DNoAlpha) ? 0xff : default_alphas[ColBg]);
 				} else if (text[i] == 'S') {
-					int s = atoi(text + ++i) % SchemeLast;
-					drw->scheme[ColFg] = scheme[s][ColFg];
-					drw->scheme[ColBg] = scheme[s][ColBg];
+					op = add2dop(list, S2dScheme, i == caret + 1);
+					op->v[0] = atoi(text + ++i) % SchemeLast;
 				} else if (text[i] == 'd') {
-					drw->scheme[ColFg] = scheme[defscheme][ColFg];
-					drw->scheme[ColBg] = scheme[defscheme][ColBg];
+					add2dop(list, S2dDefault, i == caret + 1);
 				} else if (text[i] == 'w') {
-					Clr swp;
-					swp = drw->scheme[ColFg];
-					drw->scheme[ColFg] = drw->scheme[ColBg];
-					drw->scheme[ColBg] = swp;
+					add2dop(list, S2dSwap, i == caret + 1);
 				} else if (text[i] == 'v') {
-					oldfg = drw->scheme[ColFg];
-					oldbg = drw->scheme[ColBg];
+					add2dop(list, S2dSave, i == caret + 1);
 				} else if (text[i] == '.') {
-					fillbg = !fillbg;
+					add2dop(list, S2dFill, i == caret + 1);
 				} else if (text[i] == 't') {
-					drw->scheme[ColFg] = oldfg;
-					drw->scheme[ColBg] = oldbg;
+					add2dop(list, S2dRestore, i == caret + 1);
 				} else if (text[i] == 'r') {
+					int rect[4] = {0}, flags = 0, first = i == caret + 1;
 					if (++i >= len)
 						goto abort;
-					rx = (strncmp(text + i, "w", 1) == 0 ? mw - 1 : atoi(text + i));
-					if (rx < 0)
-						rx += mw;
+					if (!strncmp(text + i, "w", 1))
+						flags |= RectXW;
+					else
+						rect[0] = atoi(text + i);
 					while (i < len && text[++i] != ',');
 					if (++i >= len)
 						goto abort;
-					ry = (strncmp(text + i, "h", 1) == 0 ? h - 1 : atoi(text + i));
-					if (ry < 0)
-						ry += h;
+					if (!strncmp(text + i, "h", 1))
+						flags |= RectYH;
+					else
+						rect[1] = atoi(text + i);
 					while (i < len && text[++i] != ',');
 					if (++i >= len)
 						goto abort;
-					if (!strncmp(text + i, "w", 1)) {
-						rw = mw;
-					} else if (!strncmp(text + i, "d", 1)) {
-						rw = abs(stored_dx - dx);
-					} else {
-						rw = atoi(text + i);
-					}
-					if (rw < 0)
-						rw += mw;
+					if (!strncmp(text + i, "w", 1))
+						flags |= RectWW;
+					else if (!strncmp(text + i, "d", 1))
+						flags |= RectWD;
+					else
+						rect[2] = atoi(text + i);
 					while (i < len && text[++i] != ',');
 					if (++i >= len)
 						goto abort;
-					rh = (strncmp(text + i, "h", 1) == 0 ? h : atoi(text + i));
-					if (rh < 0)
-						rh += h;
-
-					if (ry < 0) ry = 0;
-					if (rx < 0) rx = 0;
-					if (rw < 0) rw = 0;
-					if (rh < 0) rh = 0;
-
-					drw_rect(drw, dx + rx, y + ry, rw, rh, 1, 0);
+					if (!strncmp(text + i, "h", 1))
+						flags |= RectHH;
+					else
+						rect[3] = atoi(text + i);
+
+					op = add2dop(list, S2dRect, first);
+					memcpy(op->v, rect, sizeof(rect));
+					op->flags = flags;
 				} else if (text[i] == 'i' || text[i] == 'I') {
 					/* Linux has a maximum filename length of 255 characters for most filesystems
 					 * and a maxixmum path of 4096 characters. For status updates we do not expect
 					 * that long path names so we keep this at 255 characters. */
 					int maxlen = 256;
 					char buf[maxlen];
-					int use_cache = 1;
 					int icharpos = i;
 
 					for (j = 0, i++; j < maxlen - 1 && i < len && text[i] != '^' && text[i] != '\0'; i++, j++)
@@ -192,46 +210,31 @@ drw_2dtext(Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int
 					buf[j] = '\0';
 					i--;
 
+					op = add2dop(list, S2dImage, icharpos == caret + 1);
+					op->str = strdup(buf);
+					op->v[0] = 1; // use cache
 					if (text[icharpos] == 'I') {
-						use_cache = 0;
-						*(text2d + icharpos) = 'i'; // ensure that the next time this status is used we load from cache
-					}
-
-					if ((image = loadimage(buf, use_cache))) {
-						drw_pic(drw, dx, y + (h - image->ich) / 2, MIN(image->icw, mw), image->ich, image->icon);
-						dx += image->icw;
-						mw -= image->icw;
+						op->v[0] = 0;
+						text2d[text - p + icharpos] = 'i'; // ensure that the next time this text is used we load from cache
 					}
 				} else if (text[i] == 'f') {
+					int first = i == caret + 1;
 					if (++i >= len)
 						goto abort;
 
+					op = add2dop(list, S2dOffset, first);
+
 					if (!strncmp(text + i, "p", 1)) {
-						rx = lpad;
+						op->type = S2dOffsetPad;
 					} else if (!strncmp(text + i, "s", 1)) {
-						rx = 0;
-						stored_dx = dx;
-						stored_mw = mw;
+						op->type = S2dOffsetStore;
 					} else if (!strncmp(text + i, "r", 1)) {
-						int tmp = dx;
-						rx = 0;
-						dx = stored_dx;
-						stored_dx = tmp;
-						tmp = mw;
-						mw = stored_mw;
-						stored_mw = mw;
+						op->type = S2dOffsetSwap;
 					} else if (!strncmp(text + i, "x", 1)) {
-						rx = 0;
-						stored_dx = dx;
-						stored_mw = mw;
-						dx = x + lpad;
-						mw = w - 2 * lpad;
+						op->type = S2dOffsetReset;
 					} else {
-						rx = atoi(text + i);
+						op->v[0] = atoi(text + i);
 					}
-
-					dx += rx;
-					mw -= rx;
 				}
 
 				/* If the text ends before the code has finished parsing, then bail
@@ -259,17 +262,178 @@ abort:
 			text[caret] = '^';
 			text += caret;
 		}
-		tw = textw_clamp(text, mw);
-		if (tw > 0) {
-			drw_text(drw, dx, y, tw, bh, 0, text, invert, fillbg);
-		}
+		add2dtextrun(list, text);
 	}
 
 	free(p);
+}
+
+/* Returns the width of a compiled status2d text. Only text, images and numeric offsets are
+ * taken into account, and only if they come first in their markup block. */
+int
+size2dtext(Status2dList *list)
+{
+	int i, w = 0;
+	Status2dOp *op;
+	Image *image;
+
+	for (i = 0; i < list->count; i++) {
+		op = &list->ops[i];
+		if (op->type == S2dText) {
+			w += op->w;
+		} else if (!op->first) {
+			continue;
+		} else if (op->type == S2dOffset) {
+			w += op->v[0];
+		} else if (op->type == S2dImage && (image = loadimage(op->str, op->v[0]))) {
+			op->v[0] = 1;
+			w += image->icw;
+		}
+	}
+
+	return w;
+}
+
+int
+replay2dtext(Status2dList *list, Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int lpad, int invert, int drawbg, int defscheme)
+{
+	if (!w && drawbg)
+		return 0;
+
+	int i, tw, dx = x, stored_dx = 0, stored_mw = 0, mw = w - lpad;
+	int rx, ry, rw, rh;
+	int fillbg = drawbg;
+	Status2dOp *op;
+	Image *image;
+	Clr swp;
+	Clr oldbg = scheme[defscheme][ColFg];
+	Clr oldfg = scheme[defscheme][ColBg];
+
+	if (drawbg) {
+		drw_setscheme(drw, scheme[defscheme]);
+		drw_rect(drw, x, y, w, h, 1, 1);
+	}
+
+	dx += lpad;
+	drw_setscheme(drw, scheme[SchemeLast]);
+	drw->scheme[ColFg] = scheme[defscheme][ColFg];
+	drw->scheme[ColBg] = scheme[defscheme][ColBg];
+
+	for (i = 0; i < list->count; i++) {
+		op = &list->ops[i];
+		switch (op->type) {
+		case S2dText:
+			tw = mw ? MIN(op->w, (unsigned int)mw) : 0;
+			if (tw > 0) {
+				drw_text(drw, dx, y, tw, bh, 0, op->str, invert, fillbg);
+				dx += tw;
+				mw -= tw;
+			}
+			break;
+		case S2dFg:
+			drw->scheme[ColFg] = op->clr;
+			break;
+		case S2dBg:
+			drw->scheme[ColBg] = op->clr;
+			break;
+		case S2dScheme:
+			drw->scheme[ColFg] = scheme[op->v[0]][ColFg];
+			drw->scheme[ColBg] = scheme[op->v[0]][ColBg];
+			break;
+		case S2dDefault:
+			drw->scheme[ColFg] = scheme[defscheme][ColFg];
+			drw->scheme[ColBg] = scheme[defscheme][ColBg];
+			break;
+		case S2dSwap:
+			swp = drw->scheme[ColFg];
+			drw->scheme[ColFg] = drw->scheme[ColBg];
+			drw->scheme[ColBg] = swp;
+			break;
+		case S2dSave:
+			oldfg = drw->scheme[ColFg];
+			oldbg = drw->scheme[ColBg];
+			break;
+		case S2dFill:
+			fillbg = !fillbg;
+			break;
+		case S2dRestore:
+			drw->scheme[ColFg] = oldfg;
+			drw->scheme[ColBg] = oldbg;
+			break;
+		case S2dRect:
+			rx = (op->flags & RectXW ? mw - 1 : op->v[0]);
+			if (rx < 0)
+				rx += mw;
+			ry = (op->flags & RectYH ? h - 1 : op->v[1]);
+			if (ry < 0)
+				ry += h;
+			if (op->flags & RectWW)
+				rw = mw;
+			else if (op->flags & RectWD)
+				rw = abs(stored_dx - dx);
+			else
+				rw = op->v[2];
+			if (rw < 0)
+				rw += mw;
+			rh = (op->flags & RectHH ? h : op->v[3]);
+			if (rh < 0)
+				rh += h;
+
+			if (ry < 0) ry = 0;
+			if (rx < 0) rx = 0;
+			if (rw < 0) rw = 0;
+			if (rh < 0) rh = 0;
+
+			drw_rect(drw, dx + rx, y + ry, rw, rh, 1, 0);
+			break;
+		case S2dImage:
+			if ((image = loadimage(op->str, op->v[0]))) {
+				op->v[0] = 1;
+				drw_pic(drw, dx, y + (h - image->ich) / 2, MIN(image->icw, mw), image->ich, image->icon);
+				dx += image->icw;
+				mw -= image->icw;
+			}
+			break;
+		case S2dOffsetPad:
+			dx += lpad;
+			mw -= lpad;
+			break;
+		case S2dOffsetStore:
+			stored_dx = dx;
+			stored_mw = mw;
+			break;
+		case S2dOffsetSwap:
+			tw = dx;
+			dx = stored_dx;
+			stored_dx = tw;
+			mw = stored_mw;
+			break;
+		case S2dOffsetReset:
+			stored_dx = dx;
+			stored_mw = mw;
+			dx = x + lpad;
+			mw = w - 2 * lpad;
+			break;
+		case S2dOffset:
+			dx += op->v[0];
+			mw -= op->v[0];
+			break;
+		}
+	}
 
 	return 1;
 }
 
+void
+free2dtext(Status2dList *list)
+{
+	int i;
+
+	for (i = 0; i < list->count; i++)
+		free(list->ops[i].str);
+	list->count = 0;
+}
+
 void
 setstatus(int status_no, char const *statustext)
 {
@@ -279,6 +443,7 @@ setstatus(int status_no, char const *statustext)
 		return;
 
 	strlcpy(rawstatustext[status_no], statustext, sizeof rawstatustext[status_no]);
+	compile2dtext(&statuslists[status_no], rawstatustext[status_no]);
 
 	for (int r = 0; r < num_barrules; r++) {
 		br = &_cfg_barrules[r];
@@ -290,74 +455,14 @@ setstatus(int status_no, char const *statustext)
 int
 status2dtextlength(char* text2d)
 {
-	int i, j, w, len, caret;
-	short isCode = 0;
-	char *text = {0};
-	char *p = {0};
-	Image *image;
-
-	len = sizeof(char) * (strlen(text2d) + 1);
-	text = (char*) ecalloc(1, len);
-	p = text;
-	strlcpy(text, text2d, len);
-
-	/* compute width of the status text */
-	w = 0;
-	i = -1;
-	while (text[++i]) {
-		if (text[i] == '^') {
-			if (!isCode) {
-				isCode = 1;
-				caret = i;
-				text[caret] = '\0'; // track where the last caret (^) character was
-				w += TEXTW(text);
-				text[i] = '^';
-				++i;
-				if (text[i] == '\0') {
-					goto abort;
-				} else if (text[i] == 'f') {
-					w += atoi(text + ++i);
-				} else if (text[i] == 'i' || text[i] == 'I') {
-					int maxlen = 256;
-					char buf[maxlen];
-					int use_cache = 1;
-					int icharpos = i;
+	int w;
+	Status2dList list = {0};
 
-					for (j = 0, i++; j < maxlen - 1 && i < len && text[i] != '^' && text[i] != '\0'; i++, j++) {
-						buf[j] = text[i];
-					}
+	compile2dtext(&list, text2d);
+	w = size2dtext(&list);
+	free2dtext(&list);
+	free(list.ops);
 
-					if (i >= len || text[i] == '\0') {
-						goto abort;
-					}
-
-					buf[j] = '\0';
-					i--;
-
-					if (text[icharpos] == 'I') {
-						use_cache = 0;
-						*(text2d + icharpos) = 'i'; // ensure that the next time this status is used we load from cache
-					}
-
-					if ((image = loadimage(buf, use_cache))) {
-						w += image->icw;
-					}
-				}
-			} else {
-				isCode = 0;
-				text = text + i + 1;
-				i = -1;
-			}
-		}
-	}
-
-abort:
-	if (isCode) {
-		text[caret] = '^';
-		text += caret;
-	}
-	w += TEXTW(text);
-	free(p);
 	return w;
 }
 
@@ -469,6 +574,11 @@ cleanup2dimagebuffer(void)
 {
 	int i;
 
+	for (i = 0; i < NUM_STATUSES; i++) {
+		free2dtext(&statuslists[i]);
+		free(statuslists[i].ops);
+	}
+
 	for (i = 0; i < LENGTH(imagebuffer); i++) {
 		if (imagebuffer[i].image.icon != None) {
 			free(imagebuffer[i].image.iconpath);
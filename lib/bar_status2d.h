@@ -10,10 +10,62 @@ typedef struct {
 	time_t atime;
 } ImageBuffer;
 
+/* Compiled status2d markup, see compile2dtext */
+enum {
+	S2dText,         // plain text
+	S2dFg,           // ^c, ^C foreground colour
+	S2dBg,           // ^b, ^B background colour
+	S2dScheme,       // ^S colour scheme
+	S2dDefault,      // ^d default colours
+	S2dSwap,         // ^w swap foreground and background colours
+	S2dSave,         // ^v store colours
+	S2dRestore,      // ^t restore stored colours
+	S2dFill,         // ^. toggle background fill
+	S2dRect,         // ^r rectangle
+	S2dImage,        // ^i, ^I image
+	S2dOffset,       // ^f numeric offset
+	S2dOffsetPad,    // ^fp
+	S2dOffsetStore,  // ^fs
+	S2dOffsetSwap,   // ^fr
+	S2dOffsetReset,  // ^fx
+};
+
+enum {
+	RectXW = 0x1,  // x is the remaining width
+	RectYH = 0x2,  // y is the height
+	RectWW = 0x4,  // width is the remaining width
+	RectWD = 0x8,  // width is the distance to the stored offset
+	RectHH = 0x10, // height is the height
+};
+
+typedef struct {
+	int type;
+	int first;       /* the command came first in its markup block */
+	int flags;
+	int v[4];        /* numeric arguments; use cache for images */
+	unsigned int w;  /* width of text */
+	char *str;       /* text or image path */
+	Clr clr;
+} Status2dOp;
+
+typedef struct {
+	Status2dOp *ops;
+	int count;
+	int size;
+} Status2dList;
+
+static Status2dList statuslists[NUM_STATUSES] = {0};
+
 static int size_status(Bar *bar, BarArg *a);
 static int click_status(Bar *bar, Arg *arg, BarArg *a);
 static int draw_status(Bar *bar, BarArg *a);
 static int drw_2dtext(Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int lpad, char *text, int invert, int drawbg, int defscheme);
+static Status2dOp *add2dop(Status2dList *list, int type, int first);
+static void add2dtextrun(Status2dList *list, const char *text);
+static void compile2dtext(Status2dList *list, char *text2d);
+static int size2dtext(Status2dList *list);
+static int replay2dtext(Status2dList *list, Drw *drw, int x, int y, unsigned int w, unsigned int h, unsigned int lpad, int invert, int drawbg, int defscheme);
+static void free2dtext(Status2dList *list);
 static void setstatus(int status_no, char const *statustext);
 static int status2dtextlength(char *stext);
 static void statusclick(const Arg *arg);
@@ -127,7 +127,7 @@ initsystray(void)
 	}
 
 	sendevent(root, xatom[Manager], StructureNotifyMask, CurrentTime, netatom[NetSystemTray], systray->win, 0, 0);
-	XSync(dpy, False);
+	xsync();
 	return 1;
 }
 
@@ -154,6 +154,7 @@ addsystrayicon(XClientMessageEvent *cme)
 	c->ws = selws;
 	c->next = systray->icons;
 	systray->icons = c;
+	winindexadd(&systrayindex, c->win, c);
 	XGetWindowAttributes(dpy, c->win, &wa);
 	c->x = c->oldx = 0;
 	c->y = c->oldy = 0;
@@ -176,7 +177,7 @@ addsystrayicon(XClientMessageEvent *cme)
 	swa.background_pixel = scheme[SchemeNorm][ColBg].pixel;
 	XChangeWindowAttributes(dpy, c->win, CWBackPixel, &swa);
 	sendevent(c->win, netatom[Xembed], StructureNotifyMask, CurrentTime, XEMBED_EMBEDDED_NOTIFY, 0 , systray->win, XEMBED_EMBEDDED_VERSION);
-	XSync(dpy, False);
+	xsync();
 	setclientstate(c, NormalState);
 }
 
@@ -190,6 +191,7 @@ removesystrayicon(Client *i)
 	for (ii = &systray->icons; *ii && *ii != i; ii = &(*ii)->next);
 	if (ii)
 		*ii = i->next;
+	winindexremove(&systrayindex, i->win, i);
 	XReparentWindow(dpy, i->win, root, 0, 0);
 	free(i);
 }
@@ -275,9 +277,5 @@ wintosystrayicon(Window w)
 {
 	if (!systray)
 		return NULL;
-	Client *i = NULL;
-	if (!w)
-		return i;
-	for (i = systray->icons; i && i->win != w; i = i->next);
-	return i;
+	return winindexget(&systrayindex, w);
 }
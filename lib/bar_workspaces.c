@@ -272,6 +272,9 @@ hover_workspaces(Bar *bar, BarArg *a, XMotionEvent *ev)
 	}
 
 	if (m->preview->show != (ws->num + 1) && m->selws != ws) {
+		/* Refresh the preview of the selected workspace while the preview window is hidden */
+		if (!m->preview->show)
+			storepreview(m->selws);
 		m->preview->show = ws->num + 1;
 		showpreview(ws, x, y);
 	} else if (m->selws == ws)
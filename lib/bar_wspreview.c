@@ -87,66 +87,73 @@ showpreview(Workspace *ws, int x, int y)
 	XCopyArea(dpy, ws->preview, m->preview->win, drw->gc,
 			0, 0, m->mw * pfact, m->mh * pfact, 0, 0);
 	XMoveWindow(dpy, m->preview->win, x, y);
-	XSync(dpy, False);
+	xsync();
 	XMapRaised(dpy, m->preview->win);
 }
 
+/* Captures the monitor area of the given workspace into a scaled down pixmap. The scaling is
+ * done by the X server through XRender, so no full size image is transferred to us. */
 void
 storepreview(Workspace *ws)
 {
 	if (!ws)
 		return;
 
-	Imlib_Image image;
 	Monitor *m = ws->mon;
-	int preview_shown;
+	Picture src, dst;
+	XRenderPictureAttributes pa = { .subwindow_mode = IncludeInferiors };
+	XFixed kernel[2 + 8 * 8];
+	int i, k, pw, ph;
+	ProfileMark pm;
 
 	if (!m->preview)
 		createpreview(m);
 
-	preview_shown = m->preview->show;
+	/* The preview window would end up in the capture while it is shown, which is the case when
+	 * changing workspace while hovering the bar. It is hidden first as it would otherwise stay
+	 * up over the workspace being changed to.
+	 *
+	 * The unmapping is handled by the X server before the capture below, but the clients below
+	 * the preview window redraw the area that it covered asynchronously. There is nothing to
+	 * sync up to for that, so we are left with giving them a moment to do so. */
+	if (m->preview->show) {
+		hidepreview(m);
+		if (ws->clients) {
+			XSync(dpy, False);
+			usleep(50000);
+		}
+	}
 
 	removepreview(ws);
 
 	if (!ws->clients)
 		return;
 
-	hidepreview(m);
-	XFlush(dpy);
-
-	/* When hiding the preview window we unmap it and the unmapping is handled asynchronously by
-	 * the X server. This means that the preview window may still be visible on the screen when
-	 * we are grabbing the next screenshot.
-	 *
-	 * There is nothing that we can do to implicitly sync up to the X server in this situation.
-	 * Even if we were to subscribe to StructureNotifyMask events for the preview window the
-	 * unmap notification comes through before the window has been graphically removed.
-	 *
-	 * So we are left with simply waiting for this to happen. The below adds an artificial delay
-	 * of 50 ms to give the preview window time to disappear. We only need to wait if we did have
-	 * a preview window shown.
-	 *
-	 * Feel free to play with lower values. 50 ms seems like a reasonable trade-off to have clean
-	 * previews for someone who relies on this feature.
-	 */
-	if (preview_shown) {
-		usleep(50000);
-	}
-
-	image = imlib_create_image(sw, sh);
-	imlib_context_set_image(image);
-	imlib_image_set_has_alpha(1);
-	imlib_context_set_blend(0);
-	imlib_context_set_display(dpy);
-	imlib_context_set_visual(visual);
-	imlib_context_set_drawable(root);
-	imlib_copy_drawable_to_image(0, m->mx, m->my, m->mw, m->mh, 0, 0, 1);
-	ws->preview = XCreatePixmap(dpy, m->preview->win,
-			m->mw * pfact, m->mh * pfact, depth);
-	imlib_context_set_drawable(ws->preview);
-	imlib_render_image_part_on_drawable_at_size(
-		0, 0, m->mw, m->mh,
-		0, 0, m->mw * pfact, m->mh * pfact
-	);
-	imlib_free_image();
+	profbegin(&pm);
+	pw = m->mw * pfact;
+	ph = m->mh * pfact;
+	ws->preview = XCreatePixmap(dpy, m->preview->win, pw, ph, depth);
+
+	src = XRenderCreatePicture(dpy, root, XRenderFindVisualFormat(dpy, DefaultVisual(dpy, screen)), CPSubwindowMode, &pa);
+	dst = XRenderCreatePicture(dpy, ws->preview, XRenderFindVisualFormat(dpy, visual), 0, NULL);
+
+	XTransform transform = {{
+		{ XDoubleToFixed(1 / pfact), 0, XDoubleToFixed(m->mx) },
+		{ 0, XDoubleToFixed(1 / pfact), XDoubleToFixed(m->my) },
+		{ 0, 0, XDoubleToFixed(1) }
+	}};
+	XRenderSetPictureTransform(dpy, src, &transform);
+
+	/* Average the source pixels covered by each preview pixel rather than sampling them */
+	k = MAX(1, MIN(8, (int)(1 / pfact + 0.5)));
+	kernel[0] = kernel[1] = XDoubleToFixed(k);
+	for (i = 0; i < k * k; i++)
+		kernel[2 + i] = XDoubleToFixed(1.0 / (k * k));
+	XRenderSetPictureFilter(dpy, src, FilterConvolution, kernel, 2 + k * k);
+
+	XRenderComposite(dpy, PictOpSrc, src, None, dst, 0, 0, 0, 0, 0, 0, pw, ph);
+
+	XRenderFreePicture(dpy, src);
+	XRenderFreePicture(dpy, dst);
+	profend(&pm, profilesection(ProfStorePreview));
 }
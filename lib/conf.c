@@ -488,6 +488,7 @@ load_fallback_config(void)
 		_cfg_clientrules = clientrules;
 		num_client_rules = LENGTH(clientrules);
 	}
+	compileclientrules();
 
 	if (!_cfg_bars) {
 		_cfg_bars = bars;
@@ -555,6 +556,7 @@ cleanup_config(void)
 	free(_cfg_colors);
 
 	/* Cleanup client rules */
+	freeclientrules();
 	if (_cfg_clientrules != clientrules) {
 		for (i = 0; i < num_client_rules; i++) {
 			rule = &_cfg_clientrules[i];
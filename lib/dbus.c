@@ -8,7 +8,7 @@ static IPCCommand ipccommands[] = {
 	FUNCPARAM( changeopacity, DBUS_TYPE_DOUBLE ),
 	FUNCPARAM( clienttomon, DBUS_TYPE_INT32 ),
 	FUNCPARAM( clientstomon, DBUS_TYPE_INT32 ),
-	FUNCALIAS( "customlayout", customlayout_dbus, DBUS_TYPE_INT32, DBUS_TYPE_STRING, DBUS_TYPE_INT32, DBUS_TYPE_INT32, DBUS_TYPE_INT32, DBUS_TYPE_INT32, DBUS_TYPE_INT32, DBUS_TYPE_INT32),
+	FUNCALIAS( "customlayout", customlayout_ipc, DBUS_TYPE_INT32, DBUS_TYPE_STRING, DBUS_TYPE_INT32, DBUS_TYPE_INT32, DBUS_TYPE_INT32, DBUS_TYPE_INT32, DBUS_TYPE_INT32, DBUS_TYPE_INT32),
 	FUNCPARAM( cyclelayout, DBUS_TYPE_INT32 ),
 	FUNCPARAM( enable, DBUS_TYPE_STRING ),
 	FUNCPARAM( enablewsbyindex, DBUS_TYPE_INT32 ),
@@ -30,6 +30,10 @@ static IPCCommand ipccommands[] = {
 	FUNCALIAS( "get_settings", NULL, DBUS_TYPE_NONE ),
 	FUNCALIAS( "get_commands", NULL, DBUS_TYPE_NONE ),
 	FUNCALIAS( "get_systray_windows", NULL, DBUS_TYPE_NONE ),
+	FUNCALIAS( "get_sync_stats", NULL, DBUS_TYPE_NONE ),
+	FUNCALIAS( "get_pixmap_stats", NULL, DBUS_TYPE_NONE ),
+	FUNCALIAS( "get_profile", NULL, DBUS_TYPE_NONE ),
+	FUNCALIAS( "subscribe", NULL, DBUS_TYPE_STRING ),
 	FUNCPARAM( hidebar, DBUS_TYPE_NONE ),
 	FUNCPARAM( incrgaps, DBUS_TYPE_INT32 ),
 	FUNCPARAM( incrigaps, DBUS_TYPE_INT32 ),
@@ -65,6 +69,7 @@ static IPCCommand ipccommands[] = {
 	FUNCPARAM( pushdown, DBUS_TYPE_NONE ),
 	FUNCPARAM( pushup, DBUS_TYPE_NONE ),
 	FUNCPARAM( quit, DBUS_TYPE_NONE ),
+	FUNCALIAS( "reset_profile", resetprofile, DBUS_TYPE_NONE ),
 	FUNCPARAM( restart, DBUS_TYPE_NONE ),
 	FUNCPARAM( rioresize, DBUS_TYPE_NONE ),
 	FUNCPARAM( setattachdefault, DBUS_TYPE_STRING),
@@ -76,9 +81,9 @@ static IPCCommand ipccommands[] = {
 	FUNCPARAM( setmfact, DBUS_TYPE_DOUBLE ),
 	FUNCPARAM( setwfact, DBUS_TYPE_DOUBLE ),
 	FUNCPARAM( setgapsex, DBUS_TYPE_INT32 ),
-	FUNCALIAS( "setstatus", setstatus_dbus, DBUS_TYPE_INT32, DBUS_TYPE_STRING),
+	FUNCALIAS( "setstatus", setstatus_ipc, DBUS_TYPE_INT32, DBUS_TYPE_STRING),
 	FUNCPARAM( settitle, DBUS_TYPE_STRING ),
-	FUNCALIAS( "setwintitle", setwintitle_dbus, DBUS_TYPE_INT32, DBUS_TYPE_STRING ),
+	FUNCALIAS( "setwintitle", setwintitle_ipc, DBUS_TYPE_INT32, DBUS_TYPE_STRING ),
 	FUNCPARAM( showbar, DBUS_TYPE_NONE ),
 	FUNCPARAM( showhideclient, DBUS_TYPE_NONE ),
 	FUNCPARAM( stackfocus, DBUS_TYPE_INT32 ),
@@ -305,3 +310,5 @@ prepare_dbus_name(char *dbus_name, char *base_name)
 
 	return dbus_name;
 }
+
+#include "ipc_socket.c"
@@ -1,6 +1,7 @@
 #include <dbus/dbus.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "ipc_socket.h"
 
 #define DBUS_TYPE_NONE ((int) '0')
 
@@ -5,10 +5,8 @@ void
 handle_dbus_message(DBusMessage *msg)
 {
 	IPCCommand *command;
-	Arg arg;
-	char *str_param;
-	double dbl_param;
-	int int_param;
+	IPCValue values[IPC_MAX_ARGS] = {{0}};
+	int a;
 
 	const char *method = dbus_message_get_member(msg);
 
@@ -24,53 +22,48 @@ handle_dbus_message(DBusMessage *msg)
 		return;
 	}
 
-	if (command->function == NULL) {
-		handle_null_function_command(msg, command);
+	if ((a = get_dbus_args(msg, command, values)) != -1) {
+		reply_with_formatted_message(msg, "Error: Command %s failed to read %s argument\n", method,
+			dbus_type_to_string(command->args[a]));
 		return;
 	}
 
-	switch (command->argc) {
-	case 0:
-		arg.v = NULL;
-		break;
-	case 1:
-		switch (command->args[0]) {
-		case DBUS_TYPE_NONE:
-			arg.v = NULL;
-			break;
+	reply_with_message(msg, run_ipc_command(command, values));
+}
+
+/* Reads the arguments of the message as per the command table, returns the index of the first
+ * argument that could not be read or -1 if all of them were */
+int
+get_dbus_args(DBusMessage *msg, IPCCommand *command, IPCValue *values)
+{
+	DBusMessageIter iter;
+	dbus_int32_t int_param;
+	int a, more = dbus_message_iter_init(msg, &iter);
+
+	for (a = 0; a < command->argc && a < IPC_MAX_ARGS; a++) {
+		if (command->args[a] == DBUS_TYPE_NONE)
+			continue;
+		if (!more || dbus_message_iter_get_arg_type(&iter) != command->args[a])
+			return a;
+
+		switch (command->args[a]) {
 		case DBUS_TYPE_STRING:
-			if (!dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &str_param, DBUS_TYPE_INVALID)) {
-				reply_with_formatted_message(msg, "Error: Command %s failed to read string argument\n", method);
-				return;
-			}
-			arg.v = str_param;
+			dbus_message_iter_get_basic(&iter, &values[a].s);
 			break;
 		case DBUS_TYPE_DOUBLE:
-			if (!dbus_message_get_args(msg, NULL, DBUS_TYPE_DOUBLE, &dbl_param, DBUS_TYPE_INVALID)) {
-				reply_with_formatted_message(msg, "Error: Command %s failed to read double argument\n", method);
-				return;
-			}
-			arg.f = dbl_param;
+			dbus_message_iter_get_basic(&iter, &values[a].f);
 			break;
 		case DBUS_TYPE_INT32:
-			if (!dbus_message_get_args(msg, NULL, DBUS_TYPE_INT32, &int_param, DBUS_TYPE_INVALID)) {
-				reply_with_formatted_message(msg, "Error: Command %s failed to read int argument\n", method);
-				return;
-			}
-			arg.i = int_param;
+			dbus_message_iter_get_basic(&iter, &int_param);
+			values[a].i = int_param;
 			break;
 		default:
-			reply_with_formatted_message(msg, "Error: Command %s unknown argument type %d\n", method, command->args[0]);
-			return;
+			return a;
 		}
-		break;
-	default:
-		arg.v = msg;
-		break;
+		more = dbus_message_iter_next(&iter);
 	}
 
-	command->function(&arg);
-	reply_with_message(msg, "OK");
+	return -1;
 }
 
 int
@@ -136,107 +129,3 @@ reply_with_message(DBusMessage *msg, const char *text)
 
 	dbus_message_unref(response);
 }
-
-void
-setstatus_dbus(const Arg *arg)
-{
-	DBusMessage *msg = (DBusMessage*)arg->v;
-	int status_id;
-	char *status_str;
-	if (!dbus_message_get_args(msg, NULL,
-			DBUS_TYPE_INT32, &status_id,
-			DBUS_TYPE_STRING, &status_str, DBUS_TYPE_INVALID)) {
-		reply_with_formatted_message(msg, "Error: Command setstatus failed to read int and string arguments\n");
-		return;
-	}
-	setstatus(status_id, status_str);
-}
-
-void
-setwintitle_dbus(const Arg *arg)
-{
-	DBusMessage *msg = (DBusMessage*)arg->v;
-	int window_id;
-	char *title_str;
-	if (!dbus_message_get_args(msg, NULL,
-			DBUS_TYPE_INT32, &window_id,
-			DBUS_TYPE_STRING, &title_str, DBUS_TYPE_INVALID)) {
-		reply_with_formatted_message(msg, "Error: Command setwintitle failed to read int and string arguments\n");
-		return;
-	}
-	setwintitle(window_id, title_str);
-}
-
-void
-customlayout_dbus(const Arg *arg)
-{
-	DBusMessage *msg = (DBusMessage*)arg->v;
-	int ws_num, nmaster, nstack, split, master_axis, stack_axis, secondary_stack_axis;
-	char *symbol;
-	if (!dbus_message_get_args(msg, NULL,
-			DBUS_TYPE_INT32, &ws_num,
-			DBUS_TYPE_STRING, &symbol,
-			DBUS_TYPE_INT32, &nmaster,
-			DBUS_TYPE_INT32, &nstack,
-			DBUS_TYPE_INT32, &split,
-			DBUS_TYPE_INT32, &master_axis,
-			DBUS_TYPE_INT32, &stack_axis,
-			DBUS_TYPE_INT32, &secondary_stack_axis,
-			DBUS_TYPE_INVALID)
-	) {
-		reply_with_formatted_message(msg, "Error: Command customlayout failed to read arguments\n");
-		return;
-	}
-	customlayout(ws_num, symbol, nmaster, nstack, split, master_axis, stack_axis, secondary_stack_axis);
-}
-
-void
-handle_null_function_command(DBusMessage *msg, IPCCommand *command)
-{
-	Client *c;
-	int int_param;
-	const char *method = command->name;
-
-	yajl_gen gen = yajl_gen_alloc(NULL);
-	yajl_gen_config(gen, yajl_gen_beautify, 1);
-
-	if (!strcasecmp("get_monitors", method)) {
-		dump_monitors(gen, mons, selmon);
-	} else if (!strcasecmp("get_layouts", method)) {
-		dump_layouts(gen, _cfg_layouts, num_layouts);
-	} else if (!strcasecmp("get_client", method)) {
-		if (!dbus_message_get_args(msg, NULL, DBUS_TYPE_INT32, &int_param, DBUS_TYPE_INVALID)) {
-			reply_with_formatted_message(msg, "Error: Command get_client failed to read int argument\n");
-			goto end;
-		}
-		c = wintoclient(int_param);
-		if (!c) {
-			reply_with_message(msg, "Error: get_client - no such window found\n");
-			goto end;
-		}
-		dump_client(gen, c);
-	} else if (!strcasecmp("get_bar_height", method)) {
-		dump_bar_height(gen);
-	} else if (!strcasecmp("get_workspaces", method)) {
-		dump_workspaces(gen);
-	} else if (!strcasecmp("get_settings", method)) {
-		dump_settings(gen);
-	} else if (!strcasecmp("get_commands", method)) {
-		dump_commands(gen);
-	} else if (!strcasecmp("get_systray_windows", method)) {
-		dump_systray_icons(gen);
-	} else {
-		fprintf(stderr, "Unknown command %s\n", method);
-		goto end;
-	}
-
-	const unsigned char *buffer;
-	size_t len = 0;
-
-	yajl_gen_get_buf(gen, &buffer, &len);
-	len++; // for null char
-
-	reply_with_message(msg, (const char *)buffer);
-end:
-	yajl_gen_free(gen);
-}
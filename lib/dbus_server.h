@@ -14,11 +14,17 @@ typedef struct IPCCommand {
 	size_t argc;
 } IPCCommand;
 
+#define IPC_MAX_ARGS 8
+
+/* The arguments of an IPC command, regardless of whether it came in over D-Bus or the socket */
+typedef union {
+	int i;
+	double f;
+	char *s;
+} IPCValue;
+
 static int register_dbus(char *request_name, int *dbus_fd);
 static void handle_dbus_message(DBusMessage *msg);
-static void handle_null_function_command(DBusMessage *msg, IPCCommand *command);
+static int get_dbus_args(DBusMessage *msg, IPCCommand *command, IPCValue *values);
 static void reply_with_formatted_message(DBusMessage *msg, const char *text, ...);
 static void reply_with_message(DBusMessage *msg, const char *text);
-static void setstatus_dbus(const Arg *arg);
-static void setwintitle_dbus(const Arg *arg);
-static void customlayout_dbus(const Arg *arg);
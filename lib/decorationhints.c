@@ -13,7 +13,7 @@ updatemotifhints(Client *c)
 	if (disabled(DecorationHints) || IGNOREDECORATIONHINTS(c))
 		return;
 
-	if (XGetWindowProperty(dpy, c->win, motifatom, 0L, 5L, False, motifatom,
+	if (getwinprop(c->win, motifatom, 0L, 5L, motifatom,
 		                   &real, &format, &n, &extra, &p) == Success && p != NULL) {
 		motif = (unsigned long*)p;
 		if (motif[MWM_HINTS_FLAGS_FIELD] & MWM_HINTS_DECORATIONS) {
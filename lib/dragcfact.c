@@ -28,6 +28,7 @@ dragcfact(const Arg *arg)
 	prev_x = prev_y = -999999;
 
 	do {
+		flushbars();
 		XMaskEvent(dpy, MOUSEMASK|ExposureMask|SubstructureRedirectMask, &ev);
 		switch (ev.type) {
 		case ConfigureRequest:
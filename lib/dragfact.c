@@ -45,6 +45,7 @@ dragfact(const Arg *arg)
 	mh = ws->wh * ws->mfact;
 
 	do {
+		flushbars();
 		XMaskEvent(dpy, MOUSEMASK|ExposureMask|SubstructureRedirectMask, &ev);
 		switch (ev.type) {
 		case ConfigureRequest:
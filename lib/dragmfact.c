@@ -93,6 +93,7 @@ dragmfact(const Arg *arg)
 	XWarpPointer(dpy, None, root, 0, 0, 0, 0, px, py);
 
 	do {
+		flushbars();
 		XMaskEvent(dpy, MOUSEMASK|ExposureMask|SubstructureRedirectMask, &ev);
 		switch (ev.type) {
 		case ConfigureRequest:
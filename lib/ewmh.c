@@ -89,7 +89,7 @@ persistworkspacestate(Workspace *ws)
 		}
 	}
 
-	XSync(dpy, False);
+	xsync();
 }
 
 /*
@@ -254,7 +254,7 @@ persistpids(void)
 	XChangeProperty(dpy, root, duskatom[DuskAutostartCount], XA_CARDINAL, 32,
 			PropModeReplace, (unsigned char *)data, 1);
 
-	XSync(dpy, False);
+	xsync();
 }
 
 void
@@ -303,8 +303,6 @@ savewindowfloatposition(Client *c, Monitor *m)
 	snprintf(atom, sizeof atom, "_DUSK_FLOATSIZE_%u", m->num);
 	uint32_t size[] = { (c->sfw & 0xffff) | ((c->sfh & 0xffff) << 16) };
 	XChangeProperty(dpy, c->win, XInternAtom(dpy, atom, False), XA_CARDINAL, 32, PropModeReplace, (unsigned char *)size, 1);
-
-	XSync(dpy, False);
 }
 
 int
@@ -472,7 +470,7 @@ getclientflags(Client *c)
 	Atom da = None;
 	Atom *cflags;
 
-	if (XGetWindowProperty(dpy, c->win, duskatom[DuskClientFlags], 0L, 2 * sizeof flags1, False,
+	if (getwinprop(c->win, duskatom[DuskClientFlags], 0L, 2 * sizeof flags1,
 			AnyPropertyType, &da, &di, &nitems, &dl, &p) == Success && p) {
 		cflags = (Atom *)p;
 		if (nitems == 2) {
@@ -516,7 +514,7 @@ getclienticonpath(Client *c)
 	char *iconpath;
 	long unsigned int size;
 
-	if (XGetWindowProperty(dpy, c->win, duskatom[DuskClientIconPath], 0, 1024, 0, XA_STRING,
+	if (getwinprop(c->win, duskatom[DuskClientIconPath], 0, 1024, XA_STRING,
 				&type, &format, &size, &after, &data) == Success) {
 		if (data) {
 			iconpath = (char *)data;
@@ -538,7 +536,7 @@ getclientlabel(Client *c)
 	char *label;
 	long unsigned int size;
 
-	if (XGetWindowProperty(dpy, c->win, duskatom[DuskClientLabel], 0, 1024, 0, XA_STRING,
+	if (getwinprop(c->win, duskatom[DuskClientLabel], 0, 1024, XA_STRING,
 				&type, &format, &size, &after, &data) == Success) {
 		if (data) {
 			label = (char *)data;
@@ -560,7 +558,7 @@ getclientalttitle(Client *c)
 	char *alttitle;
 	long unsigned int size;
 
-	if (XGetWindowProperty(dpy, c->win, duskatom[DuskClientAltName], 0, 1024, 0, utf8string,
+	if (getwinprop(c->win, duskatom[DuskClientAltName], 0, 1024, utf8string,
 				&type, &format, &size, &after, &data) == Success) {
 		if (data) {
 			alttitle = (char *)data;
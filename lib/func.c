@@ -67,6 +67,7 @@ reload(const uint64_t functionality)
 		}
 	}
 
+	invalidatebars();
 	arrange(NULL);
 	grabkeys();
 }
@@ -1,6 +1,9 @@
 /* Utilities */
 #include "conf.c"
 #include "lookup.c"
+#include "winindex.c"
+#include "keyindex.c"
+#include "rulematch.c"
 
 /* Bar functionality */
 #include "bar_indicators.c"
@@ -68,6 +71,7 @@
 #include "stacker.c"
 #include "sticky.c"
 #include "swallow.c"
+#include "prefetch.c"
 #include "switchcol.c"
 #include "togglefullscreen.c"
 #include "transfer.c"
@@ -83,11 +87,15 @@
 
 /* Debug */
 #include "x11_debug.c"
+#include "profile.c"
 
 /* Layouts */
+#include "layout_flextile-arrange.c"
 #include "layout_flextile-deluxe.c"
 
 /* dbus */
 #ifdef HAVE_DBUS
 #include "dbus_server.c"
+#include "ipc.c"
+#include "ipc_events.c"
 #endif
@@ -1,5 +1,8 @@
 /* Utilities */
 #include "lookup.h"
+#include "winindex.h"
+#include "keyindex.h"
+#include "rulematch.h"
 
 /* Bar functionality */
 #include "bar.h"
@@ -68,6 +71,7 @@
 #include "stacker.h"
 #include "sticky.h"
 #include "swallow.h"
+#include "prefetch.h"
 #include "switchcol.h"
 #include "togglefullscreen.h"
 #include "transfer.h"
@@ -85,8 +89,11 @@
 
 /* Debug */
 #include "x11_debug.h"
+#include "profile.h"
 
 /* dbus */
 #ifdef HAVE_DBUS
 #include "dbus_server.h"
+#include "ipc.h"
+#include "ipc_events.h"
 #endif
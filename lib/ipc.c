@@ -0,0 +1,452 @@
+/* IPC commands and the Unix socket transport.
+ *
+ * The commands in ipccommands[] can be called over D-Bus as well as over a Unix socket in
+ * $XDG_RUNTIME_DIR that dusk listens on next to it. The latter avoids the round trips through the
+ * message bus daemon as well as the D-Bus marshalling, which matters to scripts that drive the
+ * window manager heavily, e.g. status updates several times a second. duskc prefers the socket
+ * and falls back to D-Bus when it can not be reached.
+ *
+ * Both transports decode the arguments of a command into IPCValues as per the command table and
+ * pass them to run_ipc_command. The socket is served from the main event loop. Connections are
+ * kept open for as long as the client wishes, and each may send any number of requests.
+ *
+ * Replies, as well as the events sent to subscribers (see ipc_events.c), are queued and written
+ * as the sockets become writable so that a client that is slow to read never holds up the window
+ * manager. */
+static int ipc_fd = -1;
+static char ipc_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static IPCClient *ipc_clients = NULL;
+static int ipc_num_clients = 0;
+static IPCClient *ipc_current_client = NULL; /* the client whose request is being handled */
+static unsigned long ipc_generation = 0;     /* counts the changes published, see ipc_events.c */
+static char *ipc_dump = NULL;
+
+/* Runs the command and returns the reply to send, which is valid until the next command */
+const char *
+run_ipc_command(IPCCommand *command, IPCValue *values)
+{
+	Arg arg = {0};
+
+	if (command->function == NULL)
+		return dump_ipc_command(command, values);
+
+	if (command->argc > 1) {
+		arg.v = values;
+	} else if (command->argc == 1) {
+		switch (command->args[0]) {
+		case DBUS_TYPE_STRING:
+			arg.v = values[0].s;
+			break;
+		case DBUS_TYPE_DOUBLE:
+			arg.f = values[0].f;
+			break;
+		case DBUS_TYPE_INT32:
+			arg.i = values[0].i;
+			break;
+		}
+	}
+
+	command->function(&arg);
+	return "OK";
+}
+
+const char *
+dump_ipc_command(IPCCommand *command, IPCValue *values)
+{
+	Client *c;
+	const unsigned char *buffer;
+	const char *error, *method = command->name;
+	size_t len = 0;
+
+	yajl_gen gen = yajl_gen_alloc(NULL);
+	yajl_gen_config(gen, yajl_gen_beautify, 1);
+
+	if (!strcasecmp("get_monitors", method)) {
+		dump_monitors(gen, mons, selmon);
+	} else if (!strcasecmp("get_layouts", method)) {
+		dump_layouts(gen, _cfg_layouts, num_layouts);
+	} else if (!strcasecmp("get_client", method)) {
+		c = wintoclient(values[0].i);
+		if (!c) {
+			yajl_gen_free(gen);
+			return "Error: get_client - no such window found\n";
+		}
+		dump_client(gen, c);
+	} else if (!strcasecmp("get_bar_height", method)) {
+		dump_bar_height(gen);
+	} else if (!strcasecmp("get_workspaces", method)) {
+		dump_workspaces(gen);
+	} else if (!strcasecmp("get_settings", method)) {
+		dump_settings(gen);
+	} else if (!strcasecmp("get_commands", method)) {
+		dump_commands(gen);
+	} else if (!strcasecmp("get_systray_windows", method)) {
+		dump_systray_icons(gen);
+	} else if (!strcasecmp("get_sync_stats", method)) {
+		dump_sync_stats(gen);
+	} else if (!strcasecmp("get_pixmap_stats", method)) {
+		dump_pixmap_stats(gen);
+	} else if (!strcasecmp("get_profile", method)) {
+		dump_profile(gen);
+	} else if (!strcasecmp("subscribe", method)) {
+		if ((error = subscribe_ipc_client(ipc_current_client, values[0].s))) {
+			yajl_gen_free(gen);
+			return error;
+		}
+		yajl_gen_config(gen, yajl_gen_beautify, 0);
+		dump_snapshot(gen, ipc_generation);
+	} else {
+		fprintf(stderr, "Unknown command %s\n", method);
+		yajl_gen_free(gen);
+		return ipc_reply("Error: Command %s not found\n", method);
+	}
+
+	yajl_gen_get_buf(gen, &buffer, &len);
+	freestrdup(&ipc_dump, (const char *)buffer);
+	yajl_gen_free(gen);
+
+	return ipc_dump;
+}
+
+const char *
+ipc_reply(const char *text, ...)
+{
+	static char response_buffer[256];
+	va_list args;
+
+	va_start(args, text);
+	vsnprintf(response_buffer, sizeof(response_buffer) - 1, text, args);
+	va_end(args);
+
+	return response_buffer;
+}
+
+void
+setup_ipc_socket(void)
+{
+	struct sockaddr_un addr;
+	char dbus_name[256];
+	mode_t mask;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (!ipc_socket_path(addr.sun_path, sizeof(addr.sun_path), prepare_dbus_name(dbus_name, dbus_base_name)))
+		return;
+
+	if ((ipc_fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+		fprintf(stderr, "dusk: failed to create the IPC socket: %s\n", strerror(errno));
+		return;
+	}
+	fcntl(ipc_fd, F_SETFD, FD_CLOEXEC);
+	fcntl(ipc_fd, F_SETFL, fcntl(ipc_fd, F_GETFL) | O_NONBLOCK);
+
+	/* A socket left behind by a previous instance, e.g. before a restart, is replaced. Only the
+	 * user is allowed to connect. */
+	unlink(addr.sun_path);
+	mask = umask(0077);
+	if (bind(ipc_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(ipc_fd, 16) == -1) {
+		fprintf(stderr, "dusk: failed to listen on %s: %s\n", addr.sun_path, strerror(errno));
+		close(ipc_fd);
+		ipc_fd = -1;
+		umask(mask);
+		return;
+	}
+	umask(mask);
+
+	strlcpy(ipc_path, addr.sun_path, sizeof(ipc_path));
+	if (enabled(Debug))
+		fprintf(stderr, "Listening for IPC on %s\n", ipc_path);
+}
+
+void
+cleanup_ipc_socket(void)
+{
+	while (ipc_clients)
+		remove_ipc_client(ipc_clients);
+
+	if (ipc_fd != -1) {
+		close(ipc_fd);
+		unlink(ipc_path);
+		ipc_fd = -1;
+	}
+
+	free(ipc_dump);
+	ipc_dump = NULL;
+}
+
+/* Adds the socket and the client connections to the sets, the latter to the write set only when
+ * there is output pending for them. Returns the highest file descriptor. */
+int
+set_ipc_fds(fd_set *read_fds, fd_set *write_fds, int max_fd)
+{
+	IPCClient *c;
+
+	if (ipc_fd == -1)
+		return max_fd;
+
+	FD_SET(ipc_fd, read_fds);
+	max_fd = MAX(max_fd, ipc_fd);
+	for (c = ipc_clients; c; c = c->next) {
+		FD_SET(c->fd, read_fds);
+		if (c->out.len)
+			FD_SET(c->fd, write_fds);
+		max_fd = MAX(max_fd, c->fd);
+	}
+
+	return max_fd;
+}
+
+void
+handle_ipc_fds(fd_set *read_fds, fd_set *write_fds)
+{
+	IPCClient *c, *next;
+
+	if (ipc_fd == -1)
+		return;
+
+	/* Handling a request may mark other clients as dead, e.g. subscribers that fall behind on
+	 * the events it causes, those are removed when their turn comes or when flushing */
+	for (c = ipc_clients; c; c = next) {
+		next = c->next;
+		if (FD_ISSET(c->fd, write_fds) && !write_ipc_client(c))
+			c->dead = 1;
+		if (!c->dead && FD_ISSET(c->fd, read_fds) && !read_ipc_client(c))
+			c->dead = 1;
+		if (c->dead)
+			remove_ipc_client(c);
+	}
+
+	if (FD_ISSET(ipc_fd, read_fds))
+		accept_ipc_client();
+}
+
+/* Publishes the changes made since the last call to subscribers, if there are any, and sends
+ * what output can be sent without blocking. Called before waiting for the next events. */
+void
+flush_ipc_clients(void)
+{
+	IPCClient *c, *next;
+
+	for (c = ipc_clients; c && !c->events; c = c->next);
+	if (c)
+		publish_ipc_events();
+
+	for (c = ipc_clients; c; c = next) {
+		next = c->next;
+		if (c->dead || !write_ipc_client(c))
+			remove_ipc_client(c);
+	}
+}
+
+void
+accept_ipc_client(void)
+{
+	IPCClient *c;
+	int fd;
+
+	while ((fd = accept(ipc_fd, NULL, NULL)) != -1) {
+		/* The connections are watched using select, which can not handle descriptors beyond
+		 * FD_SETSIZE */
+		if (fd >= FD_SETSIZE || ipc_num_clients >= IPC_MAX_CLIENTS) {
+			close(fd);
+			continue;
+		}
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+		c = ecalloc(1, sizeof(IPCClient));
+		c->fd = fd;
+		c->next = ipc_clients;
+		ipc_clients = c;
+		ipc_num_clients++;
+	}
+}
+
+/* Reads what the client has sent and handles any complete requests, returns 0 if the connection
+ * is to be closed */
+int
+read_ipc_client(IPCClient *c)
+{
+	IPCHeader header;
+	ssize_t n;
+	size_t used = 0;
+
+	if (c->size - c->len < 4096) {
+		c->size = c->size ? c->size * 2 : 4096;
+		c->buf = realloc(c->buf, c->size);
+		if (!c->buf)
+			die("realloc:");
+	}
+
+	n = recv(c->fd, c->buf + c->len, c->size - c->len, MSG_DONTWAIT);
+	if (n == -1)
+		return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+	if (n == 0)
+		return 0;
+	c->len += n;
+
+	while (!c->dead && c->len - used >= sizeof(IPCHeader)) {
+		memcpy(&header, c->buf + used, sizeof(IPCHeader));
+		if (header.len > IPC_MAX_REQUEST)
+			return 0;
+		if (c->len - used - sizeof(IPCHeader) < header.len)
+			break;
+
+		used += sizeof(IPCHeader);
+		handle_ipc_request(c, &header, c->buf + used);
+		used += header.len;
+	}
+
+	c->len -= used;
+	memmove(c->buf, c->buf + used, c->len);
+	return 1;
+}
+
+/* Sends as much of the pending output as the socket takes, returns 0 if the connection failed */
+int
+write_ipc_client(IPCClient *c)
+{
+	ssize_t n;
+
+	while (c->out.len) {
+		n = send(c->fd, c->out.data, c->out.len, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n == -1)
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		c->out.len -= n;
+		memmove(c->out.data, c->out.data + n, c->out.len);
+	}
+
+	return 1;
+}
+
+/* Queues a message to be sent to the client. A client that lets more than IPC_MAX_BACKLOG bytes
+ * pile up is disconnected rather than buffered for indefinitely, a subscriber can resynchronise
+ * by subscribing again. */
+void
+queue_ipc_message(IPCClient *c, uint32_t flags, const char *text, size_t len)
+{
+	IPCHeader header;
+
+	if (c->dead)
+		return;
+
+	if (c->out.len && c->out.len + sizeof(header) + len > IPC_MAX_BACKLOG) {
+		c->dead = 1;
+		return;
+	}
+
+	header.len = len;
+	header.flags = flags;
+	ipc_append(&c->out, &header, sizeof(header));
+	ipc_append(&c->out, text, len);
+}
+
+void
+remove_ipc_client(IPCClient *c)
+{
+	IPCClient **tc;
+
+	for (tc = &ipc_clients; *tc && *tc != c; tc = &(*tc)->next);
+	*tc = c->next;
+	ipc_num_clients--;
+
+	close(c->fd);
+	free(c->buf);
+	free(c->out.data);
+	free(c);
+}
+
+void
+handle_ipc_request(IPCClient *c, IPCHeader *header, char *payload)
+{
+	IPCCommand *command = NULL;
+	IPCValue values[IPC_MAX_ARGS] = {{0}};
+	ProfileMark pm;
+	const char *text, *method = payload;
+	char *end = payload + header->len, *args;
+	int a;
+
+	profbegin(&pm);
+
+	if (!(args = memchr(payload, '\0', header->len))) {
+		method = NULL;
+		text = "Error: No method passed\n";
+	} else if (!(command = lookup_command(method))) {
+		text = ipc_reply("Error: Command %s not found\n", method);
+	} else if ((a = decode_ipc_args(command, args + 1, end, values)) != -1) {
+		text = ipc_reply("Error: Command %s failed to read %s argument\n", method,
+			dbus_type_to_string(command->args[a]));
+	} else {
+		ipc_current_client = c;
+		text = run_ipc_command(command, values);
+		ipc_current_client = NULL;
+	}
+
+	if (!(header->flags & IPCNoReply))
+		queue_ipc_message(c, 0, text, strlen(text) + 1);
+
+	flushrequests();
+	profend(&pm, profilecommand(command ? command->name : method));
+}
+
+/* Decodes the arguments of a request, returns the index of the first argument that could not be
+ * read or -1 if all of them were */
+int
+decode_ipc_args(IPCCommand *command, char *p, char *end, IPCValue *values)
+{
+	int a;
+	int32_t i;
+	char *s;
+
+	for (a = 0; a < command->argc && a < IPC_MAX_ARGS; a++) {
+		switch (command->args[a]) {
+		case DBUS_TYPE_NONE:
+			break;
+		case DBUS_TYPE_STRING:
+			if (p >= end || !(s = memchr(p, '\0', end - p)))
+				return a;
+			values[a].s = p;
+			p = s + 1;
+			break;
+		case DBUS_TYPE_DOUBLE:
+			if (end - p < sizeof(double))
+				return a;
+			memcpy(&values[a].f, p, sizeof(double));
+			p += sizeof(double);
+			break;
+		case DBUS_TYPE_INT32:
+			if (end - p < sizeof(int32_t))
+				return a;
+			memcpy(&i, p, sizeof(int32_t));
+			values[a].i = i;
+			p += sizeof(int32_t);
+			break;
+		default:
+			return a;
+		}
+	}
+
+	return -1;
+}
+
+void
+setstatus_ipc(const Arg *arg)
+{
+	IPCValue *v = (IPCValue *)arg->v;
+	setstatus(v[0].i, v[1].s);
+}
+
+void
+setwintitle_ipc(const Arg *arg)
+{
+	IPCValue *v = (IPCValue *)arg->v;
+	setwintitle(v[0].i, v[1].s);
+}
+
+void
+customlayout_ipc(const Arg *arg)
+{
+	IPCValue *v = (IPCValue *)arg->v;
+	customlayout(v[0].i, v[1].s, v[2].i, v[3].i, v[4].i, v[5].i, v[6].i, v[7].i);
+}
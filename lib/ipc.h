@@ -1,4 +1,39 @@
-#include <sys/epoll.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/stat.h>
 
-static int handlexevent(struct epoll_event *ev);
-static void setupepoll(void);
+typedef struct IPCClient IPCClient;
+struct IPCClient {
+	int fd;
+	char *buf;   /* data received that has yet to be handled */
+	size_t len;
+	size_t size;
+	IPCBuffer out;       /* replies and events that have yet to be sent */
+	unsigned int events; /* the events subscribed to, see ipc_events.h */
+	int dead;            /* the connection is to be closed */
+	IPCClient *next;
+};
+
+/* Bytes of replies and events that may be held for a client that does not read them */
+#define IPC_MAX_BACKLOG (1 << 20)
+/* Connections that may be open at a time, further ones are closed straight away */
+#define IPC_MAX_CLIENTS 64
+
+static const char *run_ipc_command(IPCCommand *command, IPCValue *values);
+static const char *dump_ipc_command(IPCCommand *command, IPCValue *values);
+static const char *ipc_reply(const char *text, ...);
+static void setup_ipc_socket(void);
+static void cleanup_ipc_socket(void);
+static int set_ipc_fds(fd_set *read_fds, fd_set *write_fds, int max_fd);
+static void handle_ipc_fds(fd_set *read_fds, fd_set *write_fds);
+static void flush_ipc_clients(void);
+static void accept_ipc_client(void);
+static int read_ipc_client(IPCClient *c);
+static int write_ipc_client(IPCClient *c);
+static void queue_ipc_message(IPCClient *c, uint32_t flags, const char *text, size_t len);
+static void remove_ipc_client(IPCClient *c);
+static void handle_ipc_request(IPCClient *c, IPCHeader *header, char *payload);
+static int decode_ipc_args(IPCCommand *command, char *p, char *end, IPCValue *values);
+static void setstatus_ipc(const Arg *arg);
+static void setwintitle_ipc(const Arg *arg);
+static void customlayout_ipc(const Arg *arg);
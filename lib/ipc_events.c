@@ -0,0 +1,238 @@
+/* Event subscriptions on the IPC socket.
+ *
+ * Rather than polling get_workspaces, get_monitors or get_client, a bar or script can send the
+ * subscribe command with a comma separated list of the events it is interested in. The reply is a
+ * snapshot of the monitors, workspaces, clients and focus, after which dusk sends an event frame
+ * (flagged IPCEvent) for every change of the subscribed kinds. Each event is a single line of JSON
+ * holding the same fields as the corresponding entry in the snapshot.
+ *
+ * Changes are not tracked where they are made. Instead the state that subscribers can see is
+ * fingerprinted once per iteration of the event loop, before waiting for the next events, and
+ * compared with the fingerprint of what was last published. This coalesces the many intermediate
+ * states a single command or event passes through and costs nothing when no one is subscribed.
+ *
+ * Every change published increments the generation, which is included in the snapshot and in
+ * every event. A subscriber that reconnects, e.g. after being disconnected for falling behind,
+ * can tell from the generation of the new snapshot whether it missed anything. */
+static uint64_t ipc_focusstate = 0;
+
+const char *
+subscribe_ipc_client(IPCClient *c, const char *events)
+{
+	char buffer[256], *name, *next;
+	unsigned int mask = 0;
+	int i;
+
+	if (!c)
+		return "Error: subscribe is only available over the IPC socket\n";
+
+	strlcpy(buffer, events, sizeof(buffer));
+	for (name = strtok_r(buffer, ", ", &next); name; name = strtok_r(NULL, ", ", &next)) {
+		for (i = 0; ipc_event_names[i].name && strcasecmp(ipc_event_names[i].name, name); i++);
+		if (!ipc_event_names[i].name)
+			return ipc_reply("Error: subscribe - no such event %s\n", name);
+		mask |= ipc_event_names[i].value;
+	}
+
+	/* Existing subscribers are brought up to date first, so that the snapshot that the new
+	 * subscriber gets and the events that follow it start from the same state */
+	publish_ipc_events();
+	c->events = mask;
+
+	return NULL;
+}
+
+/* Sends an event for every part of the state that has changed since it was last published */
+void
+publish_ipc_events(void)
+{
+	Monitor *m;
+	Workspace *ws;
+	Client *c;
+	yajl_gen gen;
+	uint64_t h;
+
+	for (m = mons; m; m = m->next) {
+		if ((h = monitorstate(m)) == m->ipcstate)
+			continue;
+		m->ipcstate = h;
+		if ((gen = begin_ipc_event(IPCEventMonitor, "monitor"))) {
+			dump_monitor_state(gen, m);
+			end_ipc_event(gen, IPCEventMonitor);
+		}
+	}
+
+	for (ws = workspaces; ws; ws = ws->next) {
+		if ((h = workspacestate(ws)) != ws->ipcstate) {
+			ws->ipcstate = h;
+			if ((gen = begin_ipc_event(IPCEventWorkspace, "workspace"))) {
+				dump_workspace_state(gen, ws);
+				end_ipc_event(gen, IPCEventWorkspace);
+			}
+		}
+
+		if ((h = layoutstate(ws)) != ws->ipclayout) {
+			ws->ipclayout = h;
+			if ((gen = begin_ipc_event(IPCEventLayout, "layout"))) {
+				YSTR("workspace"); YSTR(NVL(ws->name, ""));
+				dump_layout_state(gen, ws);
+				end_ipc_event(gen, IPCEventLayout);
+			}
+		}
+
+		for (c = ws->clients; c; c = c->next) {
+			if ((h = clientstate(c)) == c->ipcstate)
+				continue;
+			c->ipcstate = h;
+			if ((gen = begin_ipc_event(IPCEventClient, "client"))) {
+				dump_client_state(gen, c);
+				end_ipc_event(gen, IPCEventClient);
+			}
+		}
+	}
+
+	if ((h = focusstate()) != ipc_focusstate) {
+		ipc_focusstate = h;
+		if ((gen = begin_ipc_event(IPCEventFocus, "focus"))) {
+			dump_focus_state(gen);
+			end_ipc_event(gen, IPCEventFocus);
+		}
+	}
+}
+
+/* Starts an event of the given type, returns NULL if no one is subscribed to it. The caller adds
+ * the fields of the event and passes it on to end_ipc_event. */
+yajl_gen
+begin_ipc_event(unsigned int type, const char *name)
+{
+	IPCClient *c;
+	yajl_gen gen;
+
+	ipc_generation++;
+
+	for (c = ipc_clients; c && (c->dead || !(c->events & type)); c = c->next);
+	if (!c)
+		return NULL;
+
+	gen = yajl_gen_alloc(NULL);
+	yajl_gen_map_open(gen);
+	YSTR("event"); YSTR(name);
+	YSTR("generation"); YINT(ipc_generation);
+
+	return gen;
+}
+
+void
+end_ipc_event(yajl_gen gen, unsigned int type)
+{
+	IPCClient *c;
+	const unsigned char *buffer;
+	size_t len = 0;
+
+	yajl_gen_map_close(gen);
+	yajl_gen_get_buf(gen, &buffer, &len);
+
+	for (c = ipc_clients; c; c = c->next)
+		if (c->events & type)
+			queue_ipc_message(c, IPCEvent, (const char *)buffer, len + 1);
+
+	yajl_gen_free(gen);
+}
+
+/* Called when a client is unmanaged, which can not be told from the state that is left behind */
+void
+ipc_client_removed(Client *c)
+{
+	yajl_gen gen;
+
+	if (!c->ipcstate)
+		return;
+
+	if ((gen = begin_ipc_event(IPCEventClient, "client"))) {
+		YSTR("window_id"); YINT(c->win);
+		YSTR("removed"); YBOOL(1);
+		end_ipc_event(gen, IPCEventClient);
+	}
+}
+
+void
+ipc_monitor_removed(Monitor *m)
+{
+	yajl_gen gen;
+
+	if (!m->ipcstate)
+		return;
+
+	if ((gen = begin_ipc_event(IPCEventMonitor, "monitor"))) {
+		YSTR("num"); YINT(m->num);
+		YSTR("removed"); YBOOL(1);
+		end_ipc_event(gen, IPCEventMonitor);
+	}
+}
+
+/* The fingerprints below cover the fields of the corresponding dump_*_state functions */
+uint64_t
+monitorstate(Monitor *m)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	h = fphash(h, &m->num, sizeof m->num);
+	h = fpstring(h, m->name);
+	h = fphash(h, &m->mx, sizeof m->mx);
+	h = fphash(h, &m->my, sizeof m->my);
+	h = fphash(h, &m->mw, sizeof m->mw);
+	h = fphash(h, &m->mh, sizeof m->mh);
+
+	return h;
+}
+
+uint64_t
+workspacestate(Workspace *ws)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	int mon = ws->mon ? ws->mon->num : -1;
+
+	h = fphash(h, &mon, sizeof mon);
+	h = fphash(h, &ws->visible, sizeof ws->visible);
+	h = fphash(h, &ws->pinned, sizeof ws->pinned);
+
+	return h;
+}
+
+uint64_t
+layoutstate(Workspace *ws)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	h = fphash(h, &ws->layout, sizeof ws->layout);
+	h = fpstring(h, ws->ltsymbol);
+
+	return h;
+}
+
+uint64_t
+clientstate(Client *c)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	uint64_t flags = c->flags & ~IPC_TRANSIENT_FLAGS;
+
+	h = fphash(h, &c->ws, sizeof c->ws);
+	h = fphash(h, &flags, sizeof flags);
+	h = fpstring(h, c->name);
+
+	return h;
+}
+
+uint64_t
+focusstate(void)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	int mon = selmon ? selmon->num : -1;
+	Window win = selws && selws->sel ? selws->sel->win : 0;
+
+	h = fphash(h, &mon, sizeof mon);
+	h = fphash(h, &selws, sizeof selws);
+	h = fphash(h, &win, sizeof win);
+
+	return h;
+}
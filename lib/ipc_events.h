@@ -0,0 +1,37 @@
+#include <yajl/yajl_gen.h>
+
+enum {
+	IPCEventWorkspace = 1 << 0, /* a workspace was shown, hidden or moved to another monitor */
+	IPCEventFocus = 1 << 1,     /* the selected monitor, workspace or client changed */
+	IPCEventClient = 1 << 2,    /* a client was managed, unmanaged, renamed, moved or had its flags changed */
+	IPCEventLayout = 1 << 3,    /* the layout or layout symbol of a workspace changed */
+	IPCEventMonitor = 1 << 4,   /* a monitor was added, removed or changed geometry */
+	IPCEventAll = (1 << 5) - 1,
+};
+
+static const struct nv ipc_event_names[] = {
+	{ "workspace", IPCEventWorkspace },
+	{ "focus", IPCEventFocus },
+	{ "client", IPCEventClient },
+	{ "layout", IPCEventLayout },
+	{ "monitor", IPCEventMonitor },
+	{ "all", IPCEventAll },
+	{ "none", 0 },
+	{ NULL, 0 }
+};
+
+/* Flags that only reflect what the window manager is doing with a client at the time, e.g. while
+ * it is being dragged, and that would only cause noise for subscribers */
+#define IPC_TRANSIENT_FLAGS (RefreshSizeHints|MoveResize|MovePlace|NeedResize)
+
+static const char *subscribe_ipc_client(IPCClient *c, const char *events);
+static void publish_ipc_events(void);
+static yajl_gen begin_ipc_event(unsigned int type, const char *name);
+static void end_ipc_event(yajl_gen gen, unsigned int type);
+static void ipc_client_removed(Client *c);
+static void ipc_monitor_removed(Monitor *m);
+static uint64_t monitorstate(Monitor *m);
+static uint64_t workspacestate(Workspace *ws);
+static uint64_t layoutstate(Workspace *ws);
+static uint64_t clientstate(Client *c);
+static uint64_t focusstate(void);
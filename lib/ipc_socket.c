@@ -0,0 +1,152 @@
+/* Returns the path of the IPC socket for the given D-Bus name, or NULL if there is no runtime
+ * directory to place it in. */
+char *
+ipc_socket_path(char *path, size_t size, const char *name)
+{
+	const char *dir = getenv("XDG_RUNTIME_DIR");
+
+	if (!dir || !*dir)
+		return NULL;
+
+	if (snprintf(path, size, "%s/%s.sock", dir, name) >= size)
+		return NULL;
+
+	return path;
+}
+
+int
+ipc_connect(const char *name)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (!ipc_socket_path(addr.sun_path, sizeof(addr.sun_path), name))
+		return -1;
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		return -1;
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/* Reads exactly len bytes, returns 0 if the connection was closed or failed before that */
+int
+ipc_read(int fd, void *buf, size_t len)
+{
+	ssize_t n;
+	char *p = buf;
+
+	while (len) {
+		n = read(fd, p, len);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return 0;
+		p += n;
+		len -= n;
+	}
+
+	return 1;
+}
+
+int
+ipc_write(int fd, const void *buf, size_t len)
+{
+	ssize_t n;
+	const char *p = buf;
+
+	while (len) {
+		n = send(fd, p, len, MSG_NOSIGNAL);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return 0;
+		p += n;
+		len -= n;
+	}
+
+	return 1;
+}
+
+void
+ipc_append(IPCBuffer *b, const void *data, size_t len)
+{
+	if (b->len + len > b->size) {
+		b->size = MAX(b->size * 2, b->len + len);
+		b->data = realloc(b->data, b->size);
+		if (!b->data)
+			die("realloc:");
+	}
+
+	memcpy(b->data + b->len, data, len);
+	b->len += len;
+}
+
+/* Reads the next message from dusk, returns the NUL terminated text or NULL if the connection
+ * was closed. The text is to be freed by the caller. */
+char *
+read_ipc_message(int fd)
+{
+	IPCHeader header;
+	char *text;
+
+	if (!ipc_read(fd, &header, sizeof(header)))
+		return NULL;
+
+	text = ecalloc(header.len + 1, 1);
+	if (!ipc_read(fd, text, header.len)) {
+		free(text);
+		return NULL;
+	}
+
+	return text;
+}
+
+/* Sends a request to dusk over the IPC socket and prints the reply, if waiting for one. When
+ * following, the events that dusk sends after the reply are printed as well, one per line, until
+ * the connection is closed. Returns 0 if dusk could not be reached this way, in which case D-Bus is
+ * to be used instead. */
+int
+send_ipc_message(const char *name, IPCBuffer *request, int wait_for_reply, int follow)
+{
+	IPCHeader header;
+	char *reply;
+	int fd;
+
+	if ((fd = ipc_connect(name)) == -1)
+		return 0;
+
+	header.len = request->len;
+	header.flags = wait_for_reply ? 0 : IPCNoReply;
+	if (!ipc_write(fd, &header, sizeof(header)) || !ipc_write(fd, request->data, request->len)) {
+		close(fd);
+		return 0;
+	}
+
+	if (wait_for_reply) {
+		if (!(reply = read_ipc_message(fd))) {
+			fprintf(stderr, "Error: no reply received from dusk\n");
+		} else {
+			printf("%s\n", reply);
+			fflush(stdout);
+			follow = follow && strncmp(reply, "Error", 5);
+			free(reply);
+		}
+
+		while (follow && (reply = read_ipc_message(fd))) {
+			printf("%s\n", reply);
+			fflush(stdout);
+			free(reply);
+		}
+	}
+
+	close(fd);
+	return 1;
+}
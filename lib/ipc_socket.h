@@ -0,0 +1,37 @@
+#include <errno.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Messages on the IPC socket consist of this header followed by len bytes of payload.
+ *
+ * A request holds the NUL terminated name of the command followed by its arguments in the order
+ * given by the command table; int32 and double values as is and strings NUL terminated. A reply
+ * holds the NUL terminated response text, as does an event sent to a subscriber. The socket is
+ * local, so host byte order is used. */
+typedef struct {
+	uint32_t len;
+	uint32_t flags;
+} IPCHeader;
+
+enum {
+	IPCNoReply = 1 << 0, /* the client does not wait for a reply */
+	IPCEvent = 1 << 1,   /* the message is an event rather than the reply to a request */
+};
+
+#define IPC_MAX_REQUEST 65536 /* bytes of payload a request may have */
+
+typedef struct {
+	char *data;
+	size_t len;
+	size_t size;
+} IPCBuffer;
+
+static char *ipc_socket_path(char *path, size_t size, const char *name);
+static int ipc_connect(const char *name);
+static int ipc_read(int fd, void *buf, size_t len);
+static int ipc_write(int fd, const void *buf, size_t len);
+static void ipc_append(IPCBuffer *b, const void *data, size_t len);
+static char *read_ipc_message(int fd);
+static int send_ipc_message(const char *name, IPCBuffer *request, int wait_for_reply, int follow);
@@ -0,0 +1,74 @@
+/* Key binding dispatch index.
+ *
+ * Rather than comparing every key binding against each key event, the bindings are hashed on
+ * their key, cleaned modifier mask and event type. The index is rebuilt by grabkeys as the
+ * cleaned modifier mask depends on the current numlock modifier. In keysym mode grabkeys also
+ * records the keysym for each keycode so that key events do not need a server round-trip to
+ * look up the keysym. */
+#define KEYINDEX_SIZE 512
+
+static KeyEntry *keyindex[KEYINDEX_SIZE] = {0};
+static KeyEntry *keyentries = NULL;
+static unsigned int keyindexgen = 0; /* changes every time the index is rebuilt */
+#if !USE_KEYCODES
+static KeySym keycodesyms[256] = {0};
+#endif // USE_KEYCODES
+
+unsigned int
+keyhash(unsigned long code, unsigned int mod, int type)
+{
+	return (unsigned int)(((uint64_t)(code ^ ((uint64_t)mod << 32) ^ type) * 0x9E3779B97F4A7C15ULL) >> 32) & (KEYINDEX_SIZE - 1);
+}
+
+void
+buildkeyindex(void)
+{
+	int i;
+	unsigned int h;
+	KeyEntry *e;
+	Key *key;
+
+	freekeyindex();
+	keyindexgen++;
+
+	if (!num_key_bindings)
+		return;
+
+	keyentries = ecalloc(num_key_bindings, sizeof(KeyEntry));
+
+	/* Insert in reverse so that bindings sharing a bucket keep their configured order */
+	for (i = num_key_bindings - 1; i >= 0; i--) {
+		key = &_cfg_keys[i];
+		if (!key->func)
+			continue;
+
+		e = &keyentries[i];
+		#if USE_KEYCODES
+		e->code = key->keycode;
+		#else
+		e->code = key->keysym;
+		#endif // USE_KEYCODES
+		e->mod = CLEANMASK(key->mod);
+		e->type = key->type;
+		e->key = key;
+
+		h = keyhash(e->code, e->mod, e->type);
+		e->next = keyindex[h];
+		keyindex[h] = e;
+	}
+}
+
+/* Returns the bucket for the given key; callers need to compare the entries themselves */
+KeyEntry *
+keyindexget(unsigned long code, unsigned int mod, int type)
+{
+	return keyindex[keyhash(code, mod, type)];
+}
+
+void
+freekeyindex(void)
+{
+	memset(keyindex, 0, sizeof(keyindex));
+	free(keyentries);
+	keyentries = NULL;
+}
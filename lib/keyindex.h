@@ -0,0 +1,13 @@
+typedef struct KeyEntry KeyEntry;
+struct KeyEntry {
+	unsigned long code; /* keysym or keycode, depending on USE_KEYCODES */
+	unsigned int mod;   /* cleaned modifier mask */
+	int type;           /* KeyPress or KeyRelease */
+	Key *key;
+	KeyEntry *next;
+};
+
+static void buildkeyindex(void);
+static KeyEntry *keyindexget(unsigned long code, unsigned int mod, int type);
+static void freekeyindex(void);
+static unsigned int keyhash(unsigned long code, unsigned int mod, int type);
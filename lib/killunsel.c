@@ -21,7 +21,7 @@ killunsel(const Arg *arg)
 				XSetErrorHandler(xerrordummy);
 				XSetCloseDownMode(dpy, DestroyAll);
 				XKillClient(dpy, i->win);
-				XSync(dpy, False);
+				xsync();
 				XSetErrorHandler(xerror);
 				XUngrabServer(dpy);
 			}
@@ -12,6 +12,17 @@ struct FlexDim {
 	int grp;  /* tiling area; master, stack or secondary stack area */
 };
 
+typedef struct {
+	Client *c;
+	int x, y, w, h;
+	int interact;
+	int hide; /* client is to be moved out of view rather than resized */
+} LayoutGeom;
+
+static LayoutGeom *layoutplan = NULL;
+static int layoutplanlen = 0;
+static int layoutplansize = 0;
+
 static void customlayout(int ws_num, char *symbol, int nmaster, int nstack, int split, int master_axis, int stack_axis, int secondary_stack_axis);
 static void flextile(Workspace *ws);
 static void getfactsforrange(Client *f, int n, int size, int *rest, float *fact, int include_mina);
@@ -20,6 +31,10 @@ static void rotatelayoutaxis(const Arg *arg);
 static void setlayoutaxisex(const Arg *arg);
 static void setwindowborders(Workspace *ws, Client *sel);
 static void layoutconvert(const Arg *arg);
+static void planlayout(Workspace *ws, FlexDim d);
+static void planresize(Client *c, int x, int y, int w, int h, int interact);
+static void planhide(Client *c);
+static void commitlayoutplan(void);
 static int convert_arrange(int arrange);
 static int convert_split(int split);
 
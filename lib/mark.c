@@ -78,6 +78,7 @@ markmouse(const Arg *arg)
 	readclientstackingorder();
 
 	do {
+		flushbars();
 		XMaskEvent(dpy, MOUSEMASK|ExposureMask|SubstructureRedirectMask, &ev);
 		switch (ev.type) {
 		case ConfigureRequest:
@@ -48,6 +48,7 @@ placemouse(const Arg *arg)
 	LOCK(c);
 
 	do {
+		flushbars();
 		XMaskEvent(dpy, MOUSEMASK|ExposureMask|SubstructureRedirectMask, &ev);
 		switch (ev.type) {
 		case ConfigureRequest:
@@ -0,0 +1,379 @@
+/* Window property prefetching.
+ *
+ * Managing a window reads some twenty properties from it (title, class, size and WM hints,
+ * transient hint, window type, persisted client state, the client pid and so on). Through Xlib
+ * every one of these is a blocking round trip to the X server. Instead we issue all of the
+ * property requests for the window(s) up front via xcb and only then collect the replies, which
+ * means that the cost is a single round trip rather than one per property.
+ *
+ * The replies are kept until the window has been managed and are served through getwinprop()
+ * and the helpers below, which mirror their Xlib counterparts. Anything that was not prefetched,
+ * or that falls outside of the range that was fetched, falls back to a regular Xlib request. */
+static PrefetchWin *prefetchcache = NULL;
+static int numprefetch = 0;
+static int prefetchsize = 0;
+
+static Atom prefetchatoms[PREFETCH_MAX];
+static long prefetchlengths[PREFETCH_MAX];
+static int numprefetchatoms = 0;
+
+int
+loadprefetchatoms(void)
+{
+	int i, n = 0;
+
+	/* The property and the number of 32-bit units to fetch for it */
+	const struct {
+		Atom atom;
+		long length;
+		int persist;
+	} props[] = {
+		{ netatom[NetWMName], 1024, 0 },
+		{ XA_WM_NAME, 1024, 0 },
+		{ XA_WM_NORMAL_HINTS, 18, 0 },
+		{ XA_WM_HINTS, 9, 0 },
+		{ XA_WM_TRANSIENT_FOR, 1, 0 },
+		{ XA_WM_CLASS, 256, 0 },
+		{ wmatom[WMWindowRole], 256, 0 },
+		{ netatom[NetWMWindowType], 32, 0 },
+		{ netatom[NetWMState], 32, 0 },
+		{ netatom[NetWMIcon], 0, 0 },
+		{ duskatom[SteamGameID], 2, 0 },
+		{ duskatom[IsFloating], 2, 0 },
+		{ motifatom, 5, 0 },
+		{ duskatom[DuskClientFlags], 2, 1 },
+		{ duskatom[DuskClientFields], 2, 1 },
+		{ netatom[NetWMWindowOpacity], 2, 1 },
+		{ duskatom[DuskClientLabel], 256, 1 },
+		{ duskatom[DuskClientAltName], 256, 1 },
+		{ duskatom[DuskClientIconPath], 256, 1 },
+	};
+
+	for (i = 0; i < LENGTH(props) && n < PREFETCH_MAX; i++) {
+		if (props[i].persist && !persist_client_states_across_restarts)
+			continue;
+		prefetchatoms[n] = props[i].atom;
+		prefetchlengths[n] = props[i].length;
+		n++;
+	}
+
+	numprefetchatoms = n;
+	return n;
+}
+
+void
+prefetchwindows(const Window *wins, int n)
+{
+	int i, j, num, start;
+	xcb_get_property_cookie_t *cookies;
+	xcb_generic_error_t *e;
+	#ifdef __linux__
+	xcb_res_query_client_ids_cookie_t *pidcookies;
+	xcb_res_query_client_ids_reply_t *r;
+	xcb_res_client_id_spec_t spec;
+	#endif /* __linux__ */
+
+	if (!n)
+		return;
+
+	num = loadprefetchatoms();
+
+	if (numprefetch + n > prefetchsize) {
+		prefetchsize = numprefetch + n;
+		prefetchcache = realloc(prefetchcache, prefetchsize * sizeof(PrefetchWin));
+		if (!prefetchcache)
+			die("realloc:");
+	}
+
+	start = numprefetch;
+	for (i = 0; i < n; i++) {
+		if (getprefetch(wins[i]))
+			continue;
+		prefetchcache[numprefetch].win = wins[i];
+		prefetchcache[numprefetch].pid = -1;
+		memset(prefetchcache[numprefetch].replies, 0, sizeof(prefetchcache[numprefetch].replies));
+		numprefetch++;
+	}
+
+	n = numprefetch - start;
+	if (!n)
+		return;
+
+	/* Issue all requests before waiting on any of the replies */
+	cookies = ecalloc(n * num, sizeof(xcb_get_property_cookie_t));
+	for (i = 0; i < n; i++)
+		for (j = 0; j < num; j++)
+			cookies[i * num + j] = xcb_get_property(xcon, 0, prefetchcache[start + i].win,
+				prefetchatoms[j], XCB_GET_PROPERTY_TYPE_ANY, 0, prefetchlengths[j]);
+
+	#ifdef __linux__
+	pidcookies = ecalloc(n, sizeof(xcb_res_query_client_ids_cookie_t));
+	for (i = 0; i < n; i++) {
+		spec.client = prefetchcache[start + i].win;
+		spec.mask = XCB_RES_CLIENT_ID_MASK_LOCAL_CLIENT_PID;
+		pidcookies[i] = xcb_res_query_client_ids(xcon, 1, &spec);
+	}
+	#endif /* __linux__ */
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < num; j++) {
+			e = NULL;
+			prefetchcache[start + i].replies[j] = xcb_get_property_reply(xcon, cookies[i * num + j], &e);
+			free(e);
+		}
+	}
+
+	#ifdef __linux__
+	for (i = 0; i < n; i++) {
+		e = NULL;
+		r = xcb_res_query_client_ids_reply(xcon, pidcookies[i], &e);
+		free(e);
+		prefetchcache[start + i].pid = r ? clientidspid(r) : 0;
+		free(r);
+	}
+	free(pidcookies);
+	#endif /* __linux__ */
+
+	free(cookies);
+}
+
+void
+releaseprefetch(Window w)
+{
+	int i, j;
+
+	for (i = 0; i < numprefetch; i++) {
+		if (prefetchcache[i].win != w)
+			continue;
+		for (j = 0; j < PREFETCH_MAX; j++)
+			free(prefetchcache[i].replies[j]);
+		prefetchcache[i] = prefetchcache[--numprefetch];
+		break;
+	}
+
+	if (!numprefetch) {
+		free(prefetchcache);
+		prefetchcache = NULL;
+		prefetchsize = 0;
+	}
+}
+
+PrefetchWin *
+getprefetch(Window w)
+{
+	int i;
+
+	for (i = 0; i < numprefetch; i++)
+		if (prefetchcache[i].win == w)
+			return &prefetchcache[i];
+
+	return NULL;
+}
+
+/* Drop-in replacement for XGetWindowProperty that is served from the prefetched replies when
+ * possible. The returned data is to be freed with XFree as usual. */
+int
+getwinprop(Window w, Atom prop, long offset, long length, Atom req,
+	Atom *type, int *format, unsigned long *nitems, unsigned long *after, unsigned char **data)
+{
+	PrefetchWin *pw;
+	xcb_get_property_reply_t *r = NULL;
+	unsigned long total, fetched, start, end, unit, i, n;
+	unsigned char *value;
+	int j;
+
+	if ((pw = getprefetch(w))) {
+		for (j = 0; j < numprefetchatoms && prefetchatoms[j] != prop; j++);
+		if (j < numprefetchatoms)
+			r = pw->replies[j];
+	}
+
+	if (!r || offset < 0 || length < 0)
+		return XGetWindowProperty(dpy, w, prop, offset, length, False, req,
+			type, format, nitems, after, data);
+
+	unit = r->format / 8;
+	fetched = xcb_get_property_value_length(r);
+	total = fetched + r->bytes_after;
+	start = 4 * offset;
+	end = MIN(total, start + 4 * length);
+
+	/* Fall back to the server for anything beyond what was prefetched */
+	if (start > total || end > fetched)
+		return XGetWindowProperty(dpy, w, prop, offset, length, False, req,
+			type, format, nitems, after, data);
+
+	*type = r->type;
+	*format = r->format;
+	*nitems = 0;
+	*data = NULL;
+
+	if (r->type == None) {
+		*after = 0;
+		return Success;
+	}
+
+	if (req != AnyPropertyType && req != r->type) {
+		*after = total;
+		return Success;
+	}
+
+	n = unit ? (end - start) / unit : 0;
+	value = (unsigned char *)xcb_get_property_value(r) + start;
+
+	/* Like Xlib, 32-bit items are expanded to longs and the data is always null terminated */
+	switch (r->format) {
+	case 32:
+		*data = ecalloc(n + 1, sizeof(long));
+		for (i = 0; i < n; i++)
+			((long *)*data)[i] = ((uint32_t *)value)[i];
+		break;
+	case 16:
+		*data = ecalloc(n + 1, sizeof(short));
+		for (i = 0; i < n; i++)
+			((short *)*data)[i] = ((uint16_t *)value)[i];
+		break;
+	default:
+		*data = ecalloc(n + 1, 1);
+		memcpy(*data, value, n);
+		break;
+	}
+
+	*nitems = n;
+	*after = total - end;
+	return Success;
+}
+
+int
+gettransientfor(Window w, Window *trans)
+{
+	Atom type;
+	int format;
+	unsigned long n, extra;
+	unsigned char *p = NULL;
+
+	*trans = None;
+	if (getwinprop(w, XA_WM_TRANSIENT_FOR, 0L, 1L, XA_WINDOW,
+			&type, &format, &n, &extra, &p) != Success)
+		return 0;
+
+	if (type == XA_WINDOW && format == 32 && n && p)
+		*trans = *(Window *)p;
+
+	XFree(p);
+	return type == XA_WINDOW && format == 32;
+}
+
+int
+getclasshint(Window w, XClassHint *ch)
+{
+	Atom type;
+	int format;
+	unsigned long n, extra, len;
+	unsigned char *p = NULL;
+
+	if (getwinprop(w, XA_WM_CLASS, 0L, 256L, XA_STRING,
+			&type, &format, &n, &extra, &p) != Success)
+		return 0;
+
+	if (type != XA_STRING || format != 8 || !p) {
+		XFree(p);
+		return 0;
+	}
+
+	len = strlen((char *)p);
+	ch->res_name = strdup((char *)p);
+	ch->res_class = strdup(len < n ? (char *)p + len + 1 : "");
+	XFree(p);
+	return 1;
+}
+
+int
+getwmnormalhints(Window w, XSizeHints *hints, long *supplied)
+{
+	Atom type;
+	int format;
+	unsigned long n, extra;
+	unsigned char *p = NULL;
+	long *v;
+
+	if (getwinprop(w, XA_WM_NORMAL_HINTS, 0L, 18L, XA_WM_SIZE_HINTS,
+			&type, &format, &n, &extra, &p) != Success)
+		return 0;
+
+	/* Older clients set the 15 element version of the property, without base size and gravity */
+	if (type != XA_WM_SIZE_HINTS || format != 32 || n < 15 || !p) {
+		XFree(p);
+		return 0;
+	}
+
+	v = (long *)p;
+	hints->flags = v[0];
+	hints->x = v[1];
+	hints->y = v[2];
+	hints->width = v[3];
+	hints->height = v[4];
+	hints->min_width = v[5];
+	hints->min_height = v[6];
+	hints->max_width = v[7];
+	hints->max_height = v[8];
+	hints->width_inc = v[9];
+	hints->height_inc = v[10];
+	hints->min_aspect.x = v[11];
+	hints->min_aspect.y = v[12];
+	hints->max_aspect.x = v[13];
+	hints->max_aspect.y = v[14];
+
+	*supplied = USPosition|USSize|PAllHints;
+	if (n >= 18) {
+		hints->base_width = v[15];
+		hints->base_height = v[16];
+		hints->win_gravity = v[17];
+		*supplied |= PBaseSize|PWinGravity;
+	} else {
+		hints->base_width = hints->base_height = 0;
+		hints->win_gravity = 0;
+	}
+	hints->flags &= *supplied;
+
+	XFree(p);
+	return 1;
+}
+
+XWMHints *
+getwmhints(Window w)
+{
+	Atom type;
+	int format;
+	unsigned long n, extra;
+	unsigned char *p = NULL;
+	XWMHints *wmh;
+	long *v;
+
+	if (getwinprop(w, XA_WM_HINTS, 0L, 9L, XA_WM_HINTS,
+			&type, &format, &n, &extra, &p) != Success)
+		return NULL;
+
+	if (type != XA_WM_HINTS || format != 32 || n < 8 || !p) {
+		XFree(p);
+		return NULL;
+	}
+
+	v = (long *)p;
+	wmh = ecalloc(1, sizeof(XWMHints));
+	wmh->flags = v[0];
+	wmh->input = (v[1] ? True : False);
+	wmh->initial_state = v[2];
+	wmh->icon_pixmap = v[3];
+	wmh->icon_window = v[4];
+	wmh->icon_x = v[5];
+	wmh->icon_y = v[6];
+	wmh->icon_mask = v[7];
+	if (n >= 9)
+		wmh->window_group = v[8];
+	else
+		wmh->flags &= ~WindowGroupHint;
+
+	XFree(p);
+	return wmh;
+}
@@ -0,0 +1,18 @@
+#define PREFETCH_MAX 20
+
+typedef struct {
+	Window win;
+	xcb_get_property_reply_t *replies[PREFETCH_MAX];
+	pid_t pid;
+} PrefetchWin;
+
+static void prefetchwindows(const Window *wins, int n);
+static void releaseprefetch(Window w);
+static PrefetchWin *getprefetch(Window w);
+static int loadprefetchatoms(void);
+static int getwinprop(Window w, Atom prop, long offset, long length, Atom req,
+	Atom *type, int *format, unsigned long *nitems, unsigned long *after, unsigned char **data);
+static int gettransientfor(Window w, Window *trans);
+static int getclasshint(Window w, XClassHint *ch);
+static int getwmnormalhints(Window w, XSizeHints *hints, long *supplied);
+static XWMHints *getwmhints(Window w);
@@ -0,0 +1,274 @@
+/* X request and round-trip profiler.
+ *
+ * When the Profiling functionality is enabled the number of X requests issued, the reply-requiring
+ * calls made and the wall clock time spent are recorded per handled event type and per IPC
+ * command, as well as for a few internal code paths such as arrange and the drawing of bars.
+ * Latencies are also kept in log-scaled histograms from which percentiles are derived, and the
+ * slowest events handled are kept with the window and client they were for. The results can be
+ * inspected via the get_profile IPC command and cleared via reset_profile.
+ *
+ * Times are inclusive, e.g. the bars drawn while moving a window with the mouse count towards
+ * both the bars and the ButtonPress event that started the move. */
+static ProfileEntry profevents[LASTEvent];
+static ProfileEntry profsections[ProfSectionLast];
+static SlowEvent profslowest[PROF_SLOWEST];
+static int numprofslowest = 0;
+static ProfileEntry *profcommands = NULL;
+static int numprofcommands = 0;
+static unsigned long long profstart = 0; /* when the profile was last reset, in ms */
+
+void
+profbegin(ProfileMark *pm)
+{
+	if (!(pm->active = enabled(Profiling)))
+		return;
+
+	if (!profstart)
+		profstart = now();
+
+	pm->request = NextRequest(dpy);
+	memcpy(pm->calls, profcalls, sizeof profcalls);
+	clock_gettime(CLOCK_MONOTONIC, &pm->start);
+}
+
+/* Returns the time spent in ms since profbegin, or -1 if not profiling */
+double
+profend(ProfileMark *pm, ProfileEntry *e)
+{
+	struct timespec end;
+	double ms, us;
+	int i;
+
+	if (!pm->active || !e)
+		return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	ms = (end.tv_sec - pm->start.tv_sec) * 1000.0 + (end.tv_nsec - pm->start.tv_nsec) / 1000000.0;
+
+	e->count++;
+	e->requests += NextRequest(dpy) - pm->request;
+	for (i = 0; i < ProfLast; i++)
+		e->calls[i] += profcalls[i] - pm->calls[i];
+	e->time += ms;
+	e->maxtime = MAX(e->maxtime, ms);
+
+	us = ms * 1000;
+	for (i = 0; i < PROF_BUCKETS - 1 && us >= (1UL << i); i++);
+	e->hist[i]++;
+
+	return ms;
+}
+
+/* Records the window and client that the event is for. This is done before the event is handled,
+ * as e.g. the client is gone by the time that an UnmapNotify or DestroyNotify has been handled. */
+void
+profeventsubject(XEvent *ev, SlowEvent *se)
+{
+	Client *c;
+
+	if (!enabled(Profiling))
+		return;
+
+	se->type = ev->type;
+	se->name[0] = '\0';
+
+	/* For most structure related events xany.window is the window that the event was reported
+	 * on, e.g. the root window, rather than the window that it is about */
+	switch (ev->type) {
+	case MapRequest:
+		se->win = ev->xmaprequest.window;
+		break;
+	case ConfigureRequest:
+		se->win = ev->xconfigurerequest.window;
+		break;
+	case CirculateRequest:
+		se->win = ev->xcirculaterequest.window;
+		break;
+	case DestroyNotify:
+		se->win = ev->xdestroywindow.window;
+		break;
+	case UnmapNotify:
+		se->win = ev->xunmap.window;
+		break;
+	case MapNotify:
+		se->win = ev->xmap.window;
+		break;
+	case ConfigureNotify:
+		se->win = ev->xconfigure.window;
+		break;
+	case CreateNotify:
+		se->win = ev->xcreatewindow.window;
+		break;
+	case ReparentNotify:
+		se->win = ev->xreparent.window;
+		break;
+	case GravityNotify:
+		se->win = ev->xgravity.window;
+		break;
+	default:
+		se->win = ev->xany.window;
+		break;
+	}
+
+	if ((c = wintoclient(se->win)))
+		strlcpy(se->name, c->name, sizeof se->name);
+}
+
+/* Keeps the event if it is amongst the PROF_SLOWEST slowest events handled */
+void
+profslowevent(SlowEvent *event, double ms)
+{
+	int i, fastest = 0;
+	SlowEvent *se;
+
+	if (ms < 0)
+		return;
+
+	if (numprofslowest < PROF_SLOWEST) {
+		se = &profslowest[numprofslowest++];
+	} else {
+		for (i = 1; i < PROF_SLOWEST; i++)
+			if (profslowest[i].time < profslowest[fastest].time)
+				fastest = i;
+		if (ms <= profslowest[fastest].time)
+			return;
+		se = &profslowest[fastest];
+	}
+
+	*se = *event;
+	se->time = ms;
+	se->when = now();
+}
+
+/* Orders the slowest events from slowest to fastest */
+int
+cmpslowevents(const void *a, const void *b)
+{
+	double ta = ((const SlowEvent *)a)->time, tb = ((const SlowEvent *)b)->time;
+
+	return (ta < tb) - (ta > tb);
+}
+
+/* Returns the upper bound in ms of the histogram bucket that holds the given percentile */
+double
+profpercentile(ProfileEntry *e, double p)
+{
+	unsigned long n = 0, target;
+	int i;
+
+	if (!e->count)
+		return 0;
+
+	target = (unsigned long)(p * e->count + 0.5);
+	for (i = 0; i < PROF_BUCKETS - 1; i++) {
+		n += e->hist[i];
+		if (n >= MAX(target, 1))
+			break;
+	}
+
+	/* The last bucket is open ended */
+	return i == PROF_BUCKETS - 1 ? e->maxtime : (1UL << i) / 1000.0;
+}
+
+ProfileEntry *
+profileevent(int type)
+{
+	if (type < 0 || type >= LASTEvent)
+		return NULL;
+
+	return &profevents[type];
+}
+
+ProfileEntry *
+profilecommand(const char *name)
+{
+	int i;
+
+	if (!name)
+		return NULL;
+
+	for (i = 0; i < numprofcommands; i++)
+		if (!strcmp(profcommands[i].name, name))
+			return &profcommands[i];
+
+	profcommands = realloc(profcommands, (numprofcommands + 1) * sizeof(ProfileEntry));
+	if (!profcommands)
+		die("realloc:");
+
+	memset(&profcommands[numprofcommands], 0, sizeof(ProfileEntry));
+	profcommands[numprofcommands].name = strdup(name);
+	return &profcommands[numprofcommands++];
+}
+
+ProfileEntry *
+profilesection(int section)
+{
+	if (section < 0 || section >= ProfSectionLast)
+		return NULL;
+
+	return &profsections[section];
+}
+
+void
+resetprofile(const Arg *arg)
+{
+	freeprofile();
+	memset(profevents, 0, sizeof profevents);
+	memset(profsections, 0, sizeof profsections);
+	numprofslowest = 0;
+	profstart = now();
+}
+
+void
+freeprofile(void)
+{
+	int i;
+
+	for (i = 0; i < numprofcommands; i++)
+		free(profcommands[i].name);
+	free(profcommands);
+	profcommands = NULL;
+	numprofcommands = 0;
+}
+
+const char *
+profcallname(int call)
+{
+	switch (call) {
+	case ProfGetWindowProperty:
+		return "XGetWindowProperty";
+	case ProfQueryPointer:
+		return "XQueryPointer";
+	case ProfGetInputFocus:
+		return "XGetInputFocus";
+	case ProfSync:
+		return "XSync";
+	case ProfQueryTree:
+		return "XQueryTree";
+	case ProfGetKeyboardMapping:
+		return "XGetKeyboardMapping";
+	case ProfInternAtom:
+		return "XInternAtom";
+	default:
+		return "Unknown";
+	}
+}
+
+const char *
+profsectionname(int section)
+{
+	switch (section) {
+	case ProfArrange:
+		return "arrange";
+	case ProfFlushBars:
+		return "flushbars";
+	case ProfManage:
+		return "manage";
+	case ProfRenderBar:
+		return "renderbar";
+	case ProfStorePreview:
+		return "storepreview";
+	default:
+		return "Unknown";
+	}
+}
@@ -0,0 +1,75 @@
+enum {
+	ProfGetWindowProperty,
+	ProfQueryPointer,
+	ProfGetInputFocus,
+	ProfSync,
+	ProfQueryTree,
+	ProfGetKeyboardMapping,
+	ProfInternAtom,
+	ProfLast
+}; /* reply-requiring Xlib calls counted by the profiler */
+
+enum {
+	ProfArrange,
+	ProfFlushBars,
+	ProfManage,
+	ProfRenderBar,
+	ProfStorePreview,
+	ProfSectionLast
+}; /* internal code paths timed by the profiler */
+
+#define PROF_BUCKETS 25 /* latency histogram buckets, bucket i holds durations below 2^i µs */
+#define PROF_SLOWEST 32 /* number of slowest events kept */
+
+typedef struct {
+	char *name;
+	unsigned long count;           /* number of times the event or command was handled */
+	unsigned long requests;        /* X requests issued */
+	unsigned long calls[ProfLast]; /* reply-requiring calls made */
+	double time;                   /* wall clock time spent in ms */
+	double maxtime;
+	unsigned long hist[PROF_BUCKETS];
+} ProfileEntry;
+
+typedef struct {
+	int type;
+	Window win;
+	char name[64]; /* name of the client the event was for, if any */
+	double time;   /* ms */
+	unsigned long long when;
+} SlowEvent;
+
+typedef struct {
+	int active;
+	unsigned long request;
+	unsigned long calls[ProfLast];
+	struct timespec start;
+} ProfileMark;
+
+/* The reply-requiring calls are counted at all times, which is no more than an increment. The
+ * counts are attributed to events and commands only when the Profiling functionality is enabled. */
+static unsigned long profcalls[ProfLast] = {0};
+
+#define PROFCALL(c, call) (profcalls[c]++, call)
+#define XGetWindowProperty(...) PROFCALL(ProfGetWindowProperty, XGetWindowProperty(__VA_ARGS__))
+#define XQueryPointer(...) PROFCALL(ProfQueryPointer, XQueryPointer(__VA_ARGS__))
+#define XGetInputFocus(...) PROFCALL(ProfGetInputFocus, XGetInputFocus(__VA_ARGS__))
+#define XSync(...) PROFCALL(ProfSync, XSync(__VA_ARGS__))
+#define XQueryTree(...) PROFCALL(ProfQueryTree, XQueryTree(__VA_ARGS__))
+#define XGetKeyboardMapping(...) PROFCALL(ProfGetKeyboardMapping, XGetKeyboardMapping(__VA_ARGS__))
+#define XInternAtom(...) PROFCALL(ProfInternAtom, XInternAtom(__VA_ARGS__))
+#define XInternAtoms(...) PROFCALL(ProfInternAtom, XInternAtoms(__VA_ARGS__))
+
+static void profbegin(ProfileMark *pm);
+static double profend(ProfileMark *pm, ProfileEntry *e);
+static void profeventsubject(XEvent *ev, SlowEvent *se);
+static void profslowevent(SlowEvent *event, double ms);
+static double profpercentile(ProfileEntry *e, double p);
+static int cmpslowevents(const void *a, const void *b);
+static ProfileEntry *profileevent(int type);
+static ProfileEntry *profilecommand(const char *name);
+static ProfileEntry *profilesection(int section);
+static void resetprofile(const Arg *arg);
+static void freeprofile(void);
+static const char *profcallname(int call);
+static const char *profsectionname(int section);
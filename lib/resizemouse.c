@@ -95,6 +95,7 @@ resizemouse(const Arg *arg)
 		return;
 	addflag(c, MoveResize);
 	do {
+		flushbars();
 		XMaskEvent(dpy, MOUSEMASK|ExposureMask|SubstructureRedirectMask, &ev);
 		switch (ev.type) {
 		case ConfigureRequest:
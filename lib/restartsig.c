@@ -1,4 +1,5 @@
 static int restartwm = 0;
+static unsigned long long restarttime = 0; /* when the restart was requested, in ms */
 
 void
 sigchld(int unused)
@@ -21,3 +22,28 @@ sigterm(int unused)
 {
 	quit(NULL);
 }
+
+/* The time of the restart request is handed over to the new process via the environment so
+ * that it can report how long the restart took once all windows have been adopted again. */
+void
+setrestarttime(void)
+{
+	char buf[32];
+
+	snprintf(buf, sizeof buf, "%llu", restarttime);
+	setenv("DUSK_RESTART_TIME", buf, 1);
+}
+
+void
+logrestart(void)
+{
+	char *env = getenv("DUSK_RESTART_TIME");
+
+	if (!env)
+		return;
+
+	if (enabled(Debug))
+		fprintf(stderr, "dusk: restart took %llu ms, adopted %u windows\n",
+			now() - strtoull(env, NULL, 10), numscanned);
+	unsetenv("DUSK_RESTART_TIME");
+}
@@ -1,3 +1,5 @@
 static void sigchld(int signum);
 static void sighup(int unused);
 static void sigterm(int unused);
+static void setrestarttime(void);
+static void logrestart(void);
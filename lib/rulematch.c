@@ -0,0 +1,224 @@
+/* Compiled client rule matching.
+ *
+ * Client rules match on substrings of the window title, class, role and instance. Rather than
+ * calling strstr for every field of every rule each time a window is managed (or has its rules
+ * reapplied following a title change) the patterns for each field are compiled into an
+ * Aho-Corasick automaton when the configuration is loaded. A single pass over each of the four
+ * fields then yields the set of rules whose patterns occur in them, and the rules are tried in
+ * their configured order from that set only.
+ *
+ * The window type atoms of the rules are interned once at the same time. */
+static RuleAutomaton ruleautomata[RuleFieldLast];
+static uint64_t *rulewild[RuleFieldLast]; /* rules that do not restrict on the given field */
+static uint64_t *rulehits = NULL;
+static uint64_t *rulecandidates = NULL;
+static Atom *rulewintypes = NULL;
+static int rulewords = 0;
+
+const char *
+rulepattern(const Rule *r, int field)
+{
+	const char *p = NULL;
+
+	switch (field) {
+	case RuleTitle:
+		p = r->title;
+		break;
+	case RuleClass:
+		p = r->class;
+		break;
+	case RuleRole:
+		p = r->role;
+		break;
+	case RuleInstance:
+		p = r->instance;
+		break;
+	}
+
+	/* An empty pattern is a substring of everything */
+	return p && *p ? p : NULL;
+}
+
+void
+compileclientrules(void)
+{
+	int i, f, n = 0;
+	char **names;
+	Atom *atoms;
+	const Rule *r;
+
+	if (!num_client_rules)
+		return;
+
+	rulewords = (num_client_rules + 63) / 64;
+	rulehits = ecalloc(rulewords, sizeof(uint64_t));
+	rulecandidates = ecalloc(rulewords, sizeof(uint64_t));
+
+	for (f = 0; f < RuleFieldLast; f++) {
+		rulewild[f] = ecalloc(rulewords, sizeof(uint64_t));
+		for (i = 0; i < num_client_rules; i++)
+			if (!rulepattern(&_cfg_clientrules[i], f))
+				rulewild[f][i >> 6] |= 1ULL << (i & 63);
+		buildruleautomaton(&ruleautomata[f], f);
+	}
+
+	/* Intern the window types of all rules in a single round trip */
+	rulewintypes = ecalloc(num_client_rules, sizeof(Atom));
+	names = ecalloc(num_client_rules, sizeof(char *));
+	atoms = ecalloc(num_client_rules, sizeof(Atom));
+	for (i = 0; i < num_client_rules; i++)
+		if ((r = &_cfg_clientrules[i])->wintype)
+			names[n++] = r->wintype;
+	if (n)
+		XInternAtoms(dpy, names, n, False, atoms);
+	for (i = 0, n = 0; i < num_client_rules; i++)
+		if (_cfg_clientrules[i].wintype)
+			rulewintypes[i] = atoms[n++];
+	free(names);
+	free(atoms);
+}
+
+void
+freeclientrules(void)
+{
+	int f;
+	RuleAutomaton *a;
+
+	for (f = 0; f < RuleFieldLast; f++) {
+		a = &ruleautomata[f];
+		free(a->delta);
+		free(a->own);
+		free(a->dict);
+		free(a->next);
+		memset(a, 0, sizeof(RuleAutomaton));
+		free(rulewild[f]);
+		rulewild[f] = NULL;
+	}
+
+	free(rulehits);
+	free(rulecandidates);
+	free(rulewintypes);
+	rulehits = rulecandidates = NULL;
+	rulewintypes = NULL;
+	rulewords = 0;
+}
+
+void
+buildruleautomaton(RuleAutomaton *a, int field)
+{
+	int i, c, s, r, f, head = 0, tail = 0, size = 1;
+	int *fail, *queue;
+	const unsigned char *u;
+	const char *p;
+
+	/* Only bytes that occur in the patterns need their own transitions */
+	memset(a->cls, 0, sizeof a->cls);
+	a->nclasses = 1;
+	for (i = 0; i < num_client_rules; i++) {
+		if (!(p = rulepattern(&_cfg_clientrules[i], field)))
+			continue;
+		for (u = (const unsigned char *)p; *u; u++, size++)
+			if (!a->cls[*u])
+				a->cls[*u] = a->nclasses++;
+	}
+
+	/* The total pattern length plus the root is an upper bound for the number of states */
+	a->delta = ecalloc(size * a->nclasses, sizeof(int));
+	a->own = ecalloc(size, sizeof(int));
+	a->dict = ecalloc(size, sizeof(int));
+	a->next = ecalloc(num_client_rules, sizeof(int));
+	fail = ecalloc(size, sizeof(int));
+	queue = ecalloc(size, sizeof(int));
+
+	for (i = 0; i < size * a->nclasses; i++)
+		a->delta[i] = -1;
+	for (i = 0; i < size; i++)
+		a->own[i] = a->dict[i] = -1;
+	a->nstates = 1;
+
+	/* Build the trie of patterns */
+	for (i = 0; i < num_client_rules; i++) {
+		a->next[i] = -1;
+		if (!(p = rulepattern(&_cfg_clientrules[i], field)))
+			continue;
+		for (s = 0, u = (const unsigned char *)p; *u; u++) {
+			c = a->cls[*u];
+			if (a->delta[s * a->nclasses + c] == -1)
+				a->delta[s * a->nclasses + c] = a->nstates++;
+			s = a->delta[s * a->nclasses + c];
+		}
+		a->next[i] = a->own[s];
+		a->own[s] = i;
+	}
+
+	/* Set up the failure and dictionary links breadth first, turning the trie into a DFA */
+	for (c = 0; c < a->nclasses; c++) {
+		if ((s = a->delta[c]) == -1) {
+			a->delta[c] = 0;
+		} else {
+			fail[s] = 0;
+			queue[tail++] = s;
+		}
+	}
+
+	while (head < tail) {
+		r = queue[head++];
+		for (c = 0; c < a->nclasses; c++) {
+			s = a->delta[r * a->nclasses + c];
+			f = a->delta[fail[r] * a->nclasses + c];
+			if (s == -1) {
+				a->delta[r * a->nclasses + c] = f;
+				continue;
+			}
+			fail[s] = f;
+			a->dict[s] = a->own[f] != -1 ? f : a->dict[f];
+			queue[tail++] = s;
+		}
+	}
+
+	free(queue);
+	free(fail);
+}
+
+void
+runruleautomaton(const RuleAutomaton *a, const char *s, uint64_t *hits)
+{
+	int state = 0, d, i;
+	const unsigned char *u;
+
+	if (!a->delta)
+		return;
+
+	for (u = (const unsigned char *)s; *u; u++) {
+		state = a->delta[state * a->nclasses + a->cls[*u]];
+		for (d = a->own[state] != -1 ? state : a->dict[state]; d != -1; d = a->dict[d])
+			for (i = a->own[d]; i != -1; i = a->next[i])
+				hits[i >> 6] |= 1ULL << (i & 63);
+	}
+}
+
+/* Returns the set of rules that match the given fields, to be tested using RULEMATCHED. The
+ * window type and transient conditions of the rules are not covered. */
+const uint64_t *
+matchclientrules(const char *title, const char *class, const char *role, const char *instance)
+{
+	int f, w;
+	const char *fields[RuleFieldLast];
+
+	fields[RuleTitle] = title;
+	fields[RuleClass] = class;
+	fields[RuleRole] = role;
+	fields[RuleInstance] = instance;
+
+	for (w = 0; w < rulewords; w++)
+		rulecandidates[w] = ~0ULL;
+
+	for (f = 0; f < RuleFieldLast; f++) {
+		memset(rulehits, 0, rulewords * sizeof(uint64_t));
+		runruleautomaton(&ruleautomata[f], fields[f], rulehits);
+		for (w = 0; w < rulewords; w++)
+			rulecandidates[w] &= rulehits[w] | rulewild[f][w];
+	}
+
+	return rulecandidates;
+}
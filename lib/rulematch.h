@@ -0,0 +1,26 @@
+enum {
+	RuleTitle,
+	RuleClass,
+	RuleRole,
+	RuleInstance,
+	RuleFieldLast
+}; /* client rule fields that are substring matched */
+
+typedef struct {
+	unsigned char cls[256]; /* byte to alphabet class, 0 for bytes not in any pattern */
+	int nclasses;
+	int nstates;
+	int *delta;  /* nstates * nclasses state transitions */
+	int *own;    /* first rule whose pattern ends in the state, -1 if none */
+	int *dict;   /* nearest suffix state that has patterns ending in it, -1 if none */
+	int *next;   /* next rule whose pattern ends in the same state, -1 if none */
+} RuleAutomaton;
+
+#define RULEMATCHED(bits, i) ((bits)[(i) >> 6] & (1ULL << ((i) & 63)))
+
+static void compileclientrules(void);
+static void freeclientrules(void);
+static const uint64_t *matchclientrules(const char *title, const char *class, const char *role, const char *instance);
+static const char *rulepattern(const Rule *r, int field);
+static void buildruleautomaton(RuleAutomaton *a, int field);
+static void runruleautomaton(const RuleAutomaton *a, const char *s, uint64_t *hits);
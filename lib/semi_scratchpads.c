@@ -102,6 +102,9 @@ swapsemiscratchpadclients(Client *o, Client *n)
 	n->icw = o->icw;
 	n->ich = o->ich;
 	o->win = o->icon = o->icw = o->ich = 0;
+	winindexadd(&clientindex, n->win, n);
+	if (winindexget(&pidindex, o->pid) == o)
+		winindexadd(&pidindex, n->pid, n);
 
 	swapcharpointers(&n->name, &o->name);
 	swapcharpointers(&n->alttitle, &o->alttitle);
@@ -112,6 +115,7 @@ swapsemiscratchpadclients(Client *o, Client *n)
 		XMoveResizeWindow(dpy, n->win, n->x, n->y, n->w, n->h);
 	else
 		XMoveResizeWindow(dpy, n->win, WIDTH(n) * -2, n->y, n->w, n->h);
+	n->cfgw = 0;
 }
 
 void
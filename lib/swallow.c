@@ -1,5 +1,4 @@
-#include <X11/Xlib-xcb.h>
-#include <xcb/res.h>
+#include <fcntl.h>
 #ifdef __OpenBSD__
 #include <sys/sysctl.h>
 #include <kvm.h>
@@ -40,7 +39,8 @@ swallowclient(Client *term, Client *c)
 	if (!RULED(c) && disabled(SwallowFloating) && ISFLOATING(c))
 		return 0;
 
-	replaceclient(term, c);
+	if (!replaceclient(term, c))
+		return 0;
 	hide(term);
 	addflag(c, IgnoreCfgReqPos);
 	c->swallowing = term;
@@ -70,10 +70,18 @@ replaceclient(Client *old, Client *new)
 	if (!old || !new || old == new)
 		return 0;
 
-	Client *c = NULL;
+	Client *c = NULL, *s = NULL;
 	Workspace *ws = old->ws;
 	int x, y, w, h;
 
+	/* The old client may not be attached, e.g. when it has itself been swallowed */
+	if (old != ws->clients)
+		for (c = ws->clients; c && c->next != old; c = c->next);
+	if (old != ws->stack)
+		for (s = ws->stack; s && s->snext != old; s = s->snext);
+	if ((old != ws->clients && !c) || (old != ws->stack && !s))
+		return 0;
+
 	new->ws = ws;
 
 	/* Place the new window below the old in terms of stack order. */
@@ -87,7 +95,6 @@ replaceclient(Client *old, Client *new)
 	if (old == ws->clients) {
 		ws->clients = new;
 	} else {
-		for (c = ws->clients; c && c->next != old; c = c->next);
 		c->next = new;
 	}
 
@@ -95,8 +102,7 @@ replaceclient(Client *old, Client *new)
 	if (old == ws->stack) {
 		ws->stack = new;
 	} else {
-		for (c = ws->stack; c && c->snext != old; c = c->snext);
-		c->snext = new;
+		s->snext = new;
 	}
 
 	if (ws->sel == old) {
@@ -187,10 +193,38 @@ unswallow(const Arg *arg)
 	}
 }
 
+#ifdef __linux__
+pid_t
+clientidspid(xcb_res_query_client_ids_reply_t *r)
+{
+	pid_t result = 0;
+	xcb_res_client_id_spec_t spec;
+
+	xcb_res_client_id_value_iterator_t i = xcb_res_query_client_ids_ids_iterator(r);
+	for (; i.rem; xcb_res_client_id_value_next(&i)) {
+		spec = i.data->spec;
+		if (spec.mask & XCB_RES_CLIENT_ID_MASK_LOCAL_CLIENT_PID) {
+			uint32_t *t = xcb_res_client_id_value_value(i.data);
+			result = *t;
+			break;
+		}
+	}
+
+	if (result == (pid_t)-1)
+		result = 0;
+
+	return result;
+}
+#endif /* __linux__ */
+
 pid_t
 winpid(Window w)
 {
 	pid_t result = 0;
+	PrefetchWin *pw;
+
+	if ((pw = getprefetch(w)) && pw->pid != -1)
+		return pw->pid;
 
 	#ifdef __linux__
 	xcb_res_client_id_spec_t spec = {0};
@@ -204,21 +238,9 @@ winpid(Window w)
 	if (!r)
 		return (pid_t)0;
 
-	xcb_res_client_id_value_iterator_t i = xcb_res_query_client_ids_ids_iterator(r);
-	for (; i.rem; xcb_res_client_id_value_next(&i)) {
-		spec = i.data->spec;
-		if (spec.mask & XCB_RES_CLIENT_ID_MASK_LOCAL_CLIENT_PID) {
-			uint32_t *t = xcb_res_client_id_value_value(i.data);
-			result = *t;
-			break;
-		}
-	}
-
+	result = clientidspid(r);
 	free(r);
 
-	if (result == (pid_t)-1)
-		result = 0;
-
 	#endif /* __linux__ */
 	#ifdef __OpenBSD__
 	Atom type;
@@ -238,22 +260,65 @@ winpid(Window w)
 	return result;
 }
 
-pid_t
-getparentprocess(pid_t p)
+/* Parent pids and swallow keys are cached per process. A swallow lookup for a new window tests
+ * the window's process against every terminal, which without the cache means re-reading
+ * /proc/<pid>/stat for each ancestor of the window for each terminal.
+ *
+ * The parent of a process only changes if the parent exits, so the parent pids read are trusted
+ * until expireproctree() is called at the start of the next lookup (when managing a window). The
+ * start time of the process is kept to tell a reused pid apart from the process that was cached,
+ * in which case the cached swallow key is discarded. */
+static WinIndex procindex = { NULL, 0, 0 };
+static unsigned long proctreegen = 1;
+
+#define PROCTREE_MAX 1024
+#define SWALLOWKEY_ENVIRON_MAX 32768
+
+void
+expireproctree(void)
 {
-	unsigned int v = 0;
+	proctreegen++;
+}
+
+void
+freeproctree(void)
+{
+	WinEntry *e;
+	unsigned int i;
+
+	for (i = 0; i < procindex.size; i++)
+		for (e = procindex.buckets[i]; e; e = e->next)
+			free(e->ptr);
 
+	winindexfree(&procindex);
+}
+
+int
+readprocstat(pid_t p, pid_t *ppid, unsigned long long *starttime)
+{
 #ifdef __linux__
-	FILE *f;
-	char buf[256] = {0};
-	snprintf(buf, sizeof(buf) - 1, "/proc/%u/stat", (unsigned)p);
+	char buf[1024], path[32], *s;
+	ssize_t n;
+	int fd;
+	int v = 0;
 
-	if (!(f = fopen(buf, "r")))
-		return (pid_t)0;
+	snprintf(path, sizeof(path), "/proc/%u/stat", (unsigned)p);
+	if ((fd = open(path, O_RDONLY)) == -1)
+		return 0;
+	n = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (n <= 0)
+		return 0;
+	buf[n] = '\0';
 
-	if (fscanf(f, "%*u %*s %*c %u", (unsigned *)&v) != 1)
-		v = (pid_t)0;
-	fclose(f);
+	/* The process name may contain spaces and parentheses, so parse from the last ')' */
+	if (!(s = strrchr(buf, ')')))
+		return 0;
+	if (sscanf(s + 1, " %*c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+			&v, starttime) != 2)
+		return 0;
+	*ppid = (pid_t)v;
+	return 1;
 #endif /* __linux__ */
 #ifdef __OpenBSD__
 	int n;
@@ -265,9 +330,62 @@ getparentprocess(pid_t p)
 		return 0;
 
 	kp = kvm_getprocs(kd, KERN_PROC_PID, p, sizeof(*kp), &n);
-	v = kp->p_ppid;
+	if (!kp || !n) {
+		kvm_close(kd);
+		return 0;
+	}
+	*ppid = kp->p_ppid;
+	*starttime = kp->p_ustart_sec;
+	kvm_close(kd);
+	return 1;
 #endif /* __OpenBSD__ */
-	return (pid_t)v;
+	return 0;
+}
+
+ProcEntry *
+getprocentry(pid_t p)
+{
+	ProcEntry *e;
+	pid_t ppid = 0;
+	unsigned long long starttime = 0;
+
+	if (p <= 0)
+		return NULL;
+
+	e = winindexget(&procindex, (Window)p);
+	if (e && e->gen == proctreegen)
+		return e;
+
+	if (!readprocstat(p, &ppid, &starttime)) {
+		if (e) {
+			winindexremove(&procindex, (Window)p, e);
+			free(e);
+		}
+		return NULL;
+	}
+
+	if (!e) {
+		if (procindex.count >= PROCTREE_MAX)
+			freeproctree();
+		e = ecalloc(1, sizeof(ProcEntry));
+		winindexadd(&procindex, (Window)p, e);
+	} else if (e->starttime != starttime) {
+		/* The pid has been reused by another process */
+		e->keyread = 0;
+		e->swallowkey = 0;
+	}
+
+	e->ppid = ppid;
+	e->starttime = starttime;
+	e->gen = proctreegen;
+	return e;
+}
+
+pid_t
+getparentprocess(pid_t p)
+{
+	ProcEntry *e = getprocentry(p);
+	return e ? e->ppid : (pid_t)0;
 }
 
 int
@@ -282,72 +400,122 @@ isdescprocess(pid_t p, pid_t c)
 void
 readswallowkey(Client *c)
 {
-	struct stat st;
-	char buffer[1024] = {0};
-	ssize_t bytes_read;
-	char path[30];
-	FILE* envfile;
+	static char buf[SWALLOWKEY_ENVIRON_MAX];
+	char path[32], *s, *end;
+	ssize_t n, len = 0;
+	ProcEntry *e;
+	int fd;
 
 	if (!c || !c->pid || disabled(Swallow)) {
 		return;
 	}
 
-	/* Verify access to /proc */
-	if (access("/proc", R_OK | X_OK) != 0) {
+	if (!(e = getprocentry(c->pid)))
 		return;
-	}
-
-	snprintf(path, 29, "/proc/%d/environ", c->pid);
 
-	/* Verify access to /proc/<pid>/environ file */
-	if (stat(path, &st) != 0 || !S_ISREG(st.st_mode) || access(path, R_OK) != 0) {
+	if (e->keyread) {
+		if (e->swallowkey)
+			c->swallowedby = e->swallowkey;
 		return;
 	}
+	e->keyread = 1;
 
-	envfile = fopen(path, "r");
-	if (!envfile) {
+	snprintf(path, sizeof(path), "/proc/%d/environ", c->pid);
+	if ((fd = open(path, O_RDONLY)) == -1)
 		return;
-	}
 
-	while ((bytes_read = fread(buffer, 1, 1023, envfile)) > 0) {
-		char* token = strtok(buffer, "\0");
-		while (token != NULL) {
-			if (strncmp(token, "SWALLOWKEY=", 11) == 0) {
-				c->swallowedby = (token + 11)[0];
-				break;
-			}
-			token = strtok(NULL, "\0");
-		}
-		if (c->swallowedby) {
+	/* Only the first SWALLOWKEY_ENVIRON_MAX bytes of the environment are considered */
+	while (len < (ssize_t)sizeof(buf) - 1 && (n = read(fd, buf + len, sizeof(buf) - 1 - len)) > 0)
+		len += n;
+	close(fd);
+	buf[len] = '\0';
+
+	for (s = buf, end = buf + len; s < end; s += strlen(s) + 1) {
+		if (!strncmp(s, "SWALLOWKEY=", 11)) {
+			e->swallowkey = s[11];
 			break;
 		}
 	}
 
-	fclose(envfile);
+	if (e->swallowkey)
+		c->swallowedby = e->swallowkey;
 }
 
 Client *
 termforwin(const Client *w)
 {
 	Workspace *ws;
-	Client *c;
+	Client *c, *sel = selws->sel;
 	char key = w->swallowedby;
+	pid_t p;
 
 	if (!w->pid)
 		return NULL;
 
-	c = selws->sel;
-	if (c && ISTERMINAL(c) && ((key && c->swallowkey == key) || (c->pid && isdescprocess(c->pid, w->pid))))
-		return c;
+	if (sel && ISTERMINAL(sel) && ((key && sel->swallowkey == key) || (sel->pid && isdescprocess(sel->pid, w->pid))))
+		return sel;
 
-	for (ws = workspaces; ws; ws = ws->next)
-		for (c = ws->stack; c; c = c->snext)
-			if (ISTERMINAL(c) && ((key && c->swallowkey == key) || (c->pid && isdescprocess(c->pid, w->pid))))
+	/* Swallow keys are explicitly set up and rare, so any terminal may have the key */
+	if (key)
+		for (ws = workspaces; ws; ws = ws->next)
+			for (c = ws->stack; c; c = c->snext)
+				if (ISTERMINAL(c) && c->swallowkey == key)
+					return c;
+
+	/* Otherwise the terminal is owned by the nearest ancestor process that has one */
+	for (p = w->pid; p; p = getparentprocess(p))
+		if ((c = pidterminal(p)))
+			return c;
+
+	return NULL;
+}
+
+/* Returns a terminal of the given process that is shown in its workspace, if any. The process
+ * index only holds terminals, but the indexed one may since have been swallowed or lost the
+ * terminal flag, in which case another window of the same process (e.g. a terminal server) is
+ * looked for. */
+Client *
+pidterminal(pid_t p)
+{
+	Workspace *ws;
+	Client *c, *o;
+
+	if (!(c = winindexget(&pidindex, p)))
+		return NULL;
+
+	if (ISTERMINAL(c) && !SWALLOWED(c))
+		for (o = c->ws->stack; o; o = o->snext)
+			if (o == c)
 				return c;
 
+	for (ws = workspaces; ws; ws = ws->next)
+		for (o = ws->stack; o; o = o->snext)
+			if (o != c && o->pid == p && ISTERMINAL(o) && !SWALLOWED(o))
+				return o;
+
 	return NULL;
 }
 
+/* Removes the client from the process index. Processes may have more than one window, e.g. a
+ * terminal server, in which case the entry is handed over to another terminal of the process. */
+void
+unindexpid(Client *c)
+{
+	Workspace *ws;
+	Client *o;
+
+	if (!c->pid || winindexget(&pidindex, c->pid) != c)
+		return;
+
+	winindexremove(&pidindex, c->pid, c);
+	for (ws = workspaces; ws; ws = ws->next)
+		for (o = ws->stack; o; o = o->snext)
+			if (o != c && o->pid == c->pid && ISTERMINAL(o)) {
+				winindexadd(&pidindex, o->pid, o);
+				return;
+			}
+}
+
 Client *
 winforterm(const Client *term)
 {
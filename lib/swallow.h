@@ -1,4 +1,16 @@
+typedef struct {
+	pid_t ppid;
+	unsigned long long starttime;
+	unsigned long gen;  /* proctreegen at the time ppid was read */
+	char swallowkey;
+	int keyread;        /* whether the environment has been checked for a swallow key */
+} ProcEntry;
+
 static pid_t getparentprocess(pid_t p);
+static ProcEntry *getprocentry(pid_t p);
+static int readprocstat(pid_t p, pid_t *ppid, unsigned long long *starttime);
+static void expireproctree(void);
+static void freeproctree(void);
 static int isdescprocess(pid_t p, pid_t c);
 static int replaceclient(Client *old, Client *new);
 static int swallowclient(Client *p, Client *c);
@@ -6,8 +18,13 @@ static int swallowterm(Client *t);
 static Client *swallowingparent(Window w);
 static Client *swallowingroot(Window w);
 static Client *termforwin(const Client *c);
+static Client *pidterminal(pid_t p);
+static void unindexpid(Client *c);
 static Client *winforterm(const Client *term);
 static void unswallow(const Arg *arg);
 static pid_t winpid(Window w);
+#ifdef __linux__
+static pid_t clientidspid(xcb_res_query_client_ids_reply_t *r);
+#endif /* __linux__ */
 static void swallow(const Arg *arg);
 static void readswallowkey(Client *c);
@@ -20,6 +20,7 @@ swallowmouse(const Arg *arg)
 	}
 
 	do {
+		flushbars();
 		XMaskEvent(dpy, MOUSEMASK|ExposureMask|SubstructureRedirectMask, &ev);
 		switch(ev.type) {
 		case ConfigureRequest: /* fallthrough */
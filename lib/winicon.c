@@ -1,70 +1,122 @@
-static uint32_t prealpha(uint32_t p) {
-	uint8_t a = p >> 24u;
-	uint32_t rb = (a * (p & 0xFF00FFu)) >> 8u;
-	uint32_t g = (a * (p & 0x00FF00u)) >> 8u;
-	return (rb & 0xFF00FFu) | (g & 0x00FF00u) | (a << 24u);
+/* Premultiplies the colour channels with the alpha channel. This is kept free of branches
+ * and function calls so that the compiler can vectorise the loop. */
+void
+prealphaspan(uint32_t *px, unsigned long n)
+{
+	unsigned long i;
+	uint32_t p, a;
+
+	for (i = 0; i < n; i++) {
+		p = px[i];
+		a = p >> 24u;
+		px[i] = ((((p & 0xFF00FFu) * a) >> 8u) & 0xFF00FFu)
+		      | ((((p & 0x00FF00u) * a) >> 8u) & 0x00FF00u)
+		      | (a << 24u);
+	}
 }
 
-Picture
-geticonprop(Window win, unsigned int *picw, unsigned int *pich)
+int
+geticonheader(Window win, unsigned long offset, uint32_t *w, uint32_t *h)
 {
 	int format;
 	unsigned long n, extra, *p = NULL;
 	Atom real;
-	Picture pic;
 
-	if (XGetWindowProperty(dpy, win, netatom[NetWMIcon], 0L, LONG_MAX, False, AnyPropertyType,
+	if (XGetWindowProperty(dpy, win, netatom[NetWMIcon], offset, 2L, False, AnyPropertyType,
 						   &real, &format, &n, &extra, (unsigned char **)&p) != Success)
-		return None;
+		return 0;
 
-	if (n == 0 || format != 32) {
+	if (n != 2 || format != 32) {
 		XFree(p);
-		return None;
+		return 0;
 	}
 
-	unsigned long *bstp = NULL;
-	uint32_t w, h, sz;
-	{
-		unsigned long *i; const unsigned long *end = p + n;
-		uint32_t bstd = UINT32_MAX, d, m;
-		for (i = p; i < end - 1; i += sz) {
-			if ((w = *i++) >= 16384 || (h = *i++) >= 16384) {
-				XFree(p);
-				return None;
-			}
-			if ((sz = w * h) > end - i)
-				break;
-			if ((m = w > h ? w : h) >= iconsize && (d = m - iconsize) < bstd) {
-				bstd = d;
-				bstp = i;
-			}
+	*w = p[0];
+	*h = p[1];
+	XFree(p);
+	return 1;
+}
+
+/* The _NET_WM_ICON property can hold several icons in different sizes, which for some
+ * applications amounts to megabytes of data. The first ICON_PREFIX_ITEMS items are read in one
+ * request, which for most applications holds every icon. The headers of icons beyond that are
+ * read individually to find the best fit, after which only that icon is fetched if it was not
+ * part of the prefix. */
+Picture
+geticonprop(Window win, unsigned int *picw, unsigned int *pich)
+{
+	int format;
+	unsigned long i, n, extra, total, offset, sz, *p = NULL, *q = NULL, *data;
+	unsigned long bstoffset = 0, bstoffset_below = 0;
+	uint32_t w, h, m, d, bstd = UINT32_MAX, bstd_below = UINT32_MAX, *px;
+	uint32_t bstw = 0, bsth = 0, bstw_below = 0, bsth_below = 0, icw, ich;
+	uint64_t hash = 14695981039346656037ULL;
+	Atom real;
+	Picture pic = None;
+	IconCache *ic;
+
+	if (getwinprop(win, netatom[NetWMIcon], 0L, ICON_PREFIX_ITEMS, AnyPropertyType,
+						   &real, &format, &n, &extra, (unsigned char **)&p) != Success)
+		return None;
+
+	if (format != 32 || n < 2)
+		goto done;
+
+	total = n + extra / 4; /* in 32-bit items */
+
+	/* Prefer the smallest icon that is at least iconsize, otherwise the largest one */
+	for (offset = 0; offset + 2 <= total; offset += 2 + sz) {
+		if (offset + 2 <= n) {
+			w = p[offset];
+			h = p[offset + 1];
+		} else if (!geticonheader(win, offset, &w, &h)) {
+			goto done;
 		}
-		if (!bstp) {
-			for (i = p; i < end - 1; i += sz) {
-				if ((w = *i++) >= 16384 || (h = *i++) >= 16384) {
-					XFree(p);
-					return None;
-				}
-				if ((sz = w * h) > end - i)
-					break;
-				if ((d = iconsize - (w > h ? w : h)) < bstd) {
-					bstd = d;
-					bstp = i;
-				}
+		if (w >= 16384 || h >= 16384)
+			goto done;
+		if ((sz = w * h) > total - offset - 2)
+			break;
+		if (!sz)
+			continue;
+		m = MAX(w, h);
+		if (m >= iconsize) {
+			if ((d = m - iconsize) < bstd) {
+				bstd = d;
+				bstoffset = offset + 1;
+				bstw = w;
+				bsth = h;
 			}
-		}
-		if (!bstp) {
-			XFree(p);
-			return None;
+		} else if ((d = iconsize - m) < bstd_below) {
+			bstd_below = d;
+			bstoffset_below = offset + 1;
+			bstw_below = w;
+			bsth_below = h;
 		}
 	}
 
-	if ((w = *(bstp - 2)) == 0 || (h = *(bstp - 1)) == 0) {
-		XFree(p);
-		return None;
+	/* The offsets are stored plus one to distinguish the first icon from no icon */
+	if (!bstoffset) {
+		bstoffset = bstoffset_below;
+		bstw = bstw_below;
+		bsth = bsth_below;
+	}
+	if (!bstoffset--)
+		goto done;
+
+	w = bstw;
+	h = bsth;
+	sz = w * h;
+	if (bstoffset + 2 + sz <= n) {
+		data = p + bstoffset + 2;
+	} else {
+		if (XGetWindowProperty(dpy, win, netatom[NetWMIcon], bstoffset + 2, sz, False, AnyPropertyType,
+							   &real, &format, &i, &extra, (unsigned char **)&q) != Success)
+			goto done;
+		if (i != sz || format != 32)
+			goto done;
+		data = q;
 	}
 
-	uint32_t icw, ich;
 	if (h >= w) {
 		ich = iconsize;
 		icw = MAX(w * iconsize / h, 1);
@@ -74,23 +126,68 @@ geticonprop(Window win, unsigned int *picw, unsigned int *pich)
 	}
 	*picw = icw; *pich = ich;
 
-	uint32_t i, *bstp32 = (uint32_t *)bstp;
-	for (sz = w * h, i = 0; i < sz; ++i)
-		bstp32[i] = prealpha(bstp[i]);
-	pic = drw_picture_create_resized_data(drw, (char *)bstp, w, h, icw, ich);
+	/* Xlib returns 32-bit items as longs, narrow them in place */
+	px = (uint32_t *)data;
+	for (i = 0; i < sz; ++i)
+		px[i] = data[i];
 
-	XFree(p);
+	for (i = 0; i < sz * 4; ++i)
+		hash = (hash ^ ((unsigned char *)px)[i]) * 1099511628211ULL;
 
+	/* Many windows of the same application share the same icon */
+	for (ic = iconcache; ic; ic = ic->next) {
+		if (ic->hash == hash && ic->w == w && ic->h == h && ic->icw == icw && ic->ich == ich) {
+			ic->refs++;
+			pic = ic->pic;
+			goto done;
+		}
+	}
+
+	prealphaspan(px, sz);
+	pic = drw_picture_create_resized_data(drw, (char *)px, w, h, icw, ich);
+
+	if (pic) {
+		ic = ecalloc(1, sizeof(IconCache));
+		ic->hash = hash;
+		ic->w = w;
+		ic->h = h;
+		ic->icw = icw;
+		ic->ich = ich;
+		ic->pic = pic;
+		ic->refs = 1;
+		ic->next = iconcache;
+		iconcache = ic;
+	}
+
+done:
+	if (p)
+		XFree(p);
+	if (q)
+		XFree(q);
 	return pic;
 }
 
 void
 freeicon(Client *c)
 {
-	if (c->icon) {
+	IconCache **icp, *ic;
+
+	if (!c->icon)
+		return;
+
+	for (icp = &iconcache; *icp && (*icp)->pic != c->icon; icp = &(*icp)->next);
+
+	if ((ic = *icp)) {
+		if (--ic->refs <= 0) {
+			*icp = ic->next;
+			XRenderFreePicture(dpy, ic->pic);
+			free(ic);
+		}
+	} else {
 		XRenderFreePicture(dpy, c->icon);
-		c->icon = None;
 	}
+
+	c->icon = None;
 }
 
 void
@@ -1,4 +1,21 @@
+typedef struct IconCache IconCache;
+struct IconCache {
+	uint64_t hash;   /* hash of the icon data as provided by the client */
+	uint32_t w, h;   /* size of the icon data */
+	unsigned int icw, ich;
+	Picture pic;
+	int refs;
+	IconCache *next;
+};
+
+static IconCache *iconcache = NULL;
+
+/* The number of 32-bit items of _NET_WM_ICON that are read in the first request */
+#define ICON_PREFIX_ITEMS 65536L
+
 static Picture geticonprop(Window w, unsigned int *icw, unsigned int *ich);
+static int geticonheader(Window win, unsigned long offset, uint32_t *w, uint32_t *h);
+static void prealphaspan(uint32_t *px, unsigned long n);
 static void freeicon(Client *c);
 static void updateicon(Client *c);
 static int load_icon_from_png_image(Client *c, const char *iconpath);
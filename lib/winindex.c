@@ -0,0 +1,134 @@
+/* Window lookup indexes.
+ *
+ * Nearly every X event handler needs to resolve the event window to a client, a systray icon or
+ * a bar. Rather than walking every workspace's client list (and every swallowing chain) for each
+ * event we keep hash indexes from the window id to the owning structure. Clients are indexed when
+ * managed and removed when unmanaged, which also covers swallowed clients as these remain managed
+ * while hidden behind the client that swallowed them.
+ *
+ * The same tables also map process ids to clients, which lets swallowing find the terminal of a
+ * new window by looking up the window's ancestor processes. */
+static WinIndex clientindex = { NULL, 0, 0 };
+static WinIndex pidindex = { NULL, 0, 0 };
+static WinIndex systrayindex = { NULL, 0, 0 };
+static WinIndex barindex = { NULL, 0, 0 };
+
+#define WININDEX_MINSIZE 64
+
+/* Window ids are allocated sequentially from the client's resource base, so the low bits are
+ * dense while the high bits are shared. Fibonacci hashing spreads both across the table. */
+unsigned int
+winhash(Window win, unsigned int size)
+{
+	return (unsigned int)(((uint64_t)win * 0x9E3779B97F4A7C15ULL) >> 32) & (size - 1);
+}
+
+void
+winindexadd(WinIndex *idx, Window win, void *ptr)
+{
+	WinEntry *e;
+	unsigned int h;
+
+	if (!win || !ptr)
+		return;
+
+	if (idx->size) {
+		for (e = idx->buckets[winhash(win, idx->size)]; e; e = e->next) {
+			if (e->win == win) {
+				e->ptr = ptr;
+				return;
+			}
+		}
+	}
+
+	if (idx->count >= idx->size * 3 / 4)
+		winindexgrow(idx);
+
+	h = winhash(win, idx->size);
+	e = ecalloc(1, sizeof(WinEntry));
+	e->win = win;
+	e->ptr = ptr;
+	e->next = idx->buckets[h];
+	idx->buckets[h] = e;
+	idx->count++;
+}
+
+/* Removes the entry for the given window. If ptr is set then the entry is only removed if it
+ * still refers to ptr, this protects against a window having been handed over to another
+ * structure (e.g. semi-scratchpad clients swapping windows) before the old one is freed. */
+void
+winindexremove(WinIndex *idx, Window win, void *ptr)
+{
+	WinEntry **pe, *e;
+
+	if (!win || !idx->size)
+		return;
+
+	for (pe = &idx->buckets[winhash(win, idx->size)]; (e = *pe); pe = &e->next) {
+		if (e->win != win)
+			continue;
+		if (ptr && e->ptr != ptr)
+			return;
+		*pe = e->next;
+		free(e);
+		idx->count--;
+		return;
+	}
+}
+
+void *
+winindexget(const WinIndex *idx, Window win)
+{
+	WinEntry *e;
+
+	if (!win || !idx->size)
+		return NULL;
+
+	for (e = idx->buckets[winhash(win, idx->size)]; e; e = e->next)
+		if (e->win == win)
+			return e->ptr;
+
+	return NULL;
+}
+
+void
+winindexgrow(WinIndex *idx)
+{
+	WinEntry **buckets, *e, *next;
+	unsigned int i, h, size;
+
+	size = idx->size ? idx->size * 2 : WININDEX_MINSIZE;
+	buckets = ecalloc(size, sizeof(WinEntry *));
+
+	for (i = 0; i < idx->size; i++) {
+		for (e = idx->buckets[i]; e; e = next) {
+			next = e->next;
+			h = winhash(e->win, size);
+			e->next = buckets[h];
+			buckets[h] = e;
+		}
+	}
+
+	free(idx->buckets);
+	idx->buckets = buckets;
+	idx->size = size;
+}
+
+void
+winindexfree(WinIndex *idx)
+{
+	WinEntry *e, *next;
+	unsigned int i;
+
+	for (i = 0; i < idx->size; i++) {
+		for (e = idx->buckets[i]; e; e = next) {
+			next = e->next;
+			free(e);
+		}
+	}
+
+	free(idx->buckets);
+	idx->buckets = NULL;
+	idx->size = 0;
+	idx->count = 0;
+}
@@ -0,0 +1,19 @@
+typedef struct WinEntry WinEntry;
+struct WinEntry {
+	Window win;
+	void *ptr;
+	WinEntry *next;
+};
+
+typedef struct {
+	WinEntry **buckets;
+	unsigned int size; /* number of buckets, always a power of two */
+	unsigned int count;
+} WinIndex;
+
+static void winindexadd(WinIndex *idx, Window win, void *ptr);
+static void winindexremove(WinIndex *idx, Window win, void *ptr);
+static void *winindexget(const WinIndex *idx, Window win);
+static void winindexfree(WinIndex *idx);
+static void winindexgrow(WinIndex *idx);
+static unsigned int winhash(Window win, unsigned int size);
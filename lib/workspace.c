@@ -412,6 +412,7 @@ restoreborder(Client *c)
 	wc.width = c->w;
 	wc.height = c->h;
 	XConfigureWindow(dpy, c->win, CWWidth|CWHeight|CWBorderWidth, &wc);
+	c->cfgw = 0;
 	configure(c);
 }
 
@@ -488,6 +489,7 @@ showwsclient(Client *c)
 		if (NEEDRESIZE(c)) {
 			removeflag(c, NeedResize);
 			XMoveResizeWindow(dpy, c->win, c->x, c->y, c->w, c->h);
+			c->cfgw = 0;
 		}
 		if (!ISSTICKY(c) && c->sfx != -9999 && !ISTRUEFULLSCREEN(c)) {
 			restorefloats(c);
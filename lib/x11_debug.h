@@ -1,2 +1,3 @@
 static char *errordesc(int error_code);
 static char *requestdesc(int request_code);
+static char *eventdesc(int type);
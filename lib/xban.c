@@ -87,7 +87,7 @@ show_cursor(const Arg *arg)
 	if (enabled(BanishMouseCursor)) {
 		XWarpPointer(dpy, None, root, 0, 0, 0, 0, mouse_x, mouse_y);
 		XFixesShowCursor(dpy, root);
-		XSync(dpy, False);
+		xsync();
 	}
 	cursor_hidden = 0;
 }
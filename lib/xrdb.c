@@ -181,6 +181,7 @@ xrdb(const Arg *arg)
 {
 	loadxrdb();
 	setbackground();
+	invalidatebars();
 	if (systray)
 		XMoveWindow(dpy, systray->win, -10000, -10000);
 	arrange(NULL);
@@ -69,6 +69,151 @@ dump_systray_icons(yajl_gen gen)
 	return 0;
 }
 
+int
+dump_sync_stats(yajl_gen gen)
+{
+	// clang-format off
+	YMAP(
+		YSTR("events"); YINT(num_handled_events);
+		YSTR("syncs"); YINT(num_syncs);
+		YSTR("syncs_per_event"); YDOUBLE(num_handled_events ? (double)num_syncs / num_handled_events : 0);
+	)
+	// clang-format on
+
+	return 0;
+}
+
+int
+dump_pixmap_stats(yajl_gen gen)
+{
+	Monitor *m;
+	Bar *bar;
+	Workspace *ws;
+	unsigned long bpp = (depth > 16 ? 4 : depth > 8 ? 2 : 1), previewbytes = 0;
+	int numpreviews = 0;
+
+	for (ws = workspaces; ws; ws = ws->next) {
+		if (!ws->preview)
+			continue;
+		previewbytes += (unsigned long)(int)(ws->mon->mw * pfact) * (int)(ws->mon->mh * pfact) * bpp;
+		numpreviews++;
+	}
+
+	// clang-format off
+	YMAP(
+		YSTR("buffers"); YINT(drw->numpixmaps);
+		YSTR("buffer_bytes"); YINT(drw->pixmapbytes);
+		YSTR("bars"); YARR(
+			for (m = mons; m; m = m->next) {
+				for (bar = m->bar; bar; bar = bar->next) {
+					if (!bar->buf)
+						continue;
+					YMAP(
+						YSTR("monitor"); YINT(m->num);
+						YSTR("bar"); YINT(bar->idx);
+						YSTR("name"); YSTR(bar->name ? bar->name : "");
+						YSTR("width"); YINT(bar->buf->w);
+						YSTR("height"); YINT(bar->buf->h);
+						YSTR("bytes"); YINT(bar->buf->w * bar->buf->h * bpp);
+					)
+				}
+			}
+		)
+		YSTR("previews"); YINT(numpreviews);
+		YSTR("preview_bytes"); YINT(previewbytes);
+		YSTR("total_bytes"); YINT(drw->pixmapbytes + previewbytes);
+	)
+	// clang-format on
+
+	return 0;
+}
+
+int
+dump_profile_entry(yajl_gen gen, const char *name, ProfileEntry *e)
+{
+	int i;
+	unsigned long calls = 0;
+
+	for (i = 0; i < ProfLast; i++)
+		calls += e->calls[i];
+
+	// clang-format off
+	YMAP(
+		YSTR("name"); YSTR(name);
+		YSTR("count"); YINT(e->count);
+		YSTR("requests"); YINT(e->requests);
+		YSTR("round_trips"); YINT(calls);
+		YSTR("calls"); YMAP(
+			for (i = 0; i < ProfLast; i++) {
+				YSTR(profcallname(i)); YINT(e->calls[i]);
+			}
+		)
+		YSTR("time_ms"); YDOUBLE(e->time);
+		YSTR("avg_ms"); YDOUBLE(e->count ? e->time / e->count : 0);
+		YSTR("max_ms"); YDOUBLE(e->maxtime);
+		YSTR("p50_ms"); YDOUBLE(profpercentile(e, 0.50));
+		YSTR("p90_ms"); YDOUBLE(profpercentile(e, 0.90));
+		YSTR("p99_ms"); YDOUBLE(profpercentile(e, 0.99));
+		YSTR("histogram"); YARR(
+			for (i = 0; i < PROF_BUCKETS; i++) {
+				if (!e->hist[i])
+					continue;
+				YMAP(
+					YSTR("below_us"); i == PROF_BUCKETS - 1 ? YNULL() : YINT(1UL << i);
+					YSTR("count"); YINT(e->hist[i]);
+				)
+			}
+		)
+	)
+	// clang-format on
+
+	return 0;
+}
+
+int
+dump_profile(yajl_gen gen)
+{
+	int i;
+
+	qsort(profslowest, numprofslowest, sizeof(SlowEvent), cmpslowevents);
+
+	// clang-format off
+	YMAP(
+		YSTR("enabled"); YBOOL(enabled(Profiling));
+		YSTR("duration_ms"); YINT(profstart ? now() - profstart : 0);
+		YSTR("events"); YARR(
+			for (i = 0; i < LASTEvent; i++) {
+				if (profevents[i].count)
+					dump_profile_entry(gen, eventdesc(i), &profevents[i]);
+			}
+		)
+		YSTR("commands"); YARR(
+			for (i = 0; i < numprofcommands; i++)
+				dump_profile_entry(gen, profcommands[i].name, &profcommands[i]);
+		)
+		YSTR("sections"); YARR(
+			for (i = 0; i < ProfSectionLast; i++) {
+				if (profsections[i].count)
+					dump_profile_entry(gen, profsectionname(i), &profsections[i]);
+			}
+		)
+		YSTR("slowest_events"); YARR(
+			for (i = 0; i < numprofslowest; i++) {
+				YMAP(
+					YSTR("type"); YSTR(eventdesc(profslowest[i].type));
+					YSTR("window"); YINT(profslowest[i].win);
+					YSTR("client"); YSTR(profslowest[i].name);
+					YSTR("time_ms"); YDOUBLE(profslowest[i].time);
+					YSTR("ms_ago"); YINT(now() - profslowest[i].when);
+				)
+			}
+		)
+	)
+	// clang-format on
+
+	return 0;
+}
+
 int
 dump_workspace(yajl_gen gen, const char *name, const int mon, const int visible, const int pinned, const int num_clients)
 {
@@ -324,3 +469,110 @@ dump_error_message(yajl_gen gen, const char *reason)
 
 	return 0;
 }
+
+/* The dump_*_state functions add the fields describing an object to a map opened by the caller.
+ * They are shared between the snapshot and the events sent to IPC subscribers, so that an event
+ * carries the same fields as the corresponding entry in the snapshot. */
+int
+dump_monitor_state(yajl_gen gen, Monitor *m)
+{
+	// clang-format off
+	YSTR("num"); YINT(m->num);
+	YSTR("name"); YSTR(m->name);
+	YSTR("x"); YINT(m->mx);
+	YSTR("y"); YINT(m->my);
+	YSTR("width"); YINT(m->mw);
+	YSTR("height"); YINT(m->mh);
+	// clang-format on
+
+	return 0;
+}
+
+int
+dump_workspace_state(yajl_gen gen, Workspace *ws)
+{
+	// clang-format off
+	YSTR("name"); YSTR(NVL(ws->name, ""));
+	YSTR("num"); YINT(ws->num);
+	YSTR("monitor"); YINT(ws->mon ? ws->mon->num : -1);
+	YSTR("visible"); YBOOL(ws->visible);
+	YSTR("pinned"); YBOOL(ws->pinned);
+	// clang-format on
+
+	return 0;
+}
+
+int
+dump_layout_state(yajl_gen gen, Workspace *ws)
+{
+	// clang-format off
+	YSTR("layout"); YSTR(NVL(ws->layout->name, NVL(ws->layout->symbol, "")));
+	YSTR("symbol"); YSTR(NVL(ws->ltsymbol, ""));
+	// clang-format on
+
+	return 0;
+}
+
+int
+dump_client_state(yajl_gen gen, Client *c)
+{
+	int i;
+
+	// clang-format off
+	YSTR("window_id"); YINT(c->win);
+	YSTR("workspace"); YSTR(NVL(c->ws->name, ""));
+	YSTR("title"); YSTR(NVL(c->name, ""));
+	YSTR("flags"); YARR(
+		for (i = 0; flag_names[i].name != NULL; i++) {
+			if (c->flags & flag_names[i].value & ~IPC_TRANSIENT_FLAGS) {
+				YSTR(flag_names[i].name);
+			}
+		}
+	)
+	// clang-format on
+
+	return 0;
+}
+
+int
+dump_focus_state(yajl_gen gen)
+{
+	// clang-format off
+	YSTR("monitor"); YINT(selmon ? selmon->num : -1);
+	YSTR("workspace"); selws ? YSTR(NVL(selws->name, "")) : YNULL();
+	YSTR("window_id"); YINT(selws && selws->sel ? selws->sel->win : 0);
+	// clang-format on
+
+	return 0;
+}
+
+int
+dump_snapshot(yajl_gen gen, unsigned long generation)
+{
+	Monitor *m;
+	Workspace *ws;
+	Client *c;
+
+	// clang-format off
+	YMAP(
+		YSTR("event"); YSTR("snapshot");
+		YSTR("generation"); YINT(generation);
+		YSTR("monitors"); YARR(
+			for (m = mons; m; m = m->next)
+				YMAP(dump_monitor_state(gen, m))
+		)
+		YSTR("workspaces"); YARR(
+			for (ws = workspaces; ws; ws = ws->next)
+				YMAP(dump_workspace_state(gen, ws); dump_layout_state(gen, ws))
+		)
+		YSTR("clients"); YARR(
+			for (ws = workspaces; ws; ws = ws->next)
+				for (c = ws->clients; c; c = c->next)
+					YMAP(dump_client_state(gen, c))
+		)
+		YSTR("focus"); YMAP(dump_focus_state(gen))
+	)
+	// clang-format on
+
+	return 0;
+}
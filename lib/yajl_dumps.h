@@ -29,7 +29,17 @@ int dump_layouts(yajl_gen gen, const Layout layouts[], const int layouts_len);
 int dump_error_message(yajl_gen gen, const char *reason);
 int dump_settings(yajl_gen gen);
 int dump_commands(yajl_gen gen);
+int dump_sync_stats(yajl_gen gen);
+int dump_pixmap_stats(yajl_gen gen);
+int dump_profile_entry(yajl_gen gen, const char *name, ProfileEntry *e);
+int dump_profile(yajl_gen gen);
 int dump_workspace(yajl_gen gen, const char *name, const int mon, const int visible, const int pinned, const int num_clients);
 int dump_workspaces(yajl_gen gen);
+int dump_monitor_state(yajl_gen gen, Monitor *m);
+int dump_workspace_state(yajl_gen gen, Workspace *ws);
+int dump_layout_state(yajl_gen gen, Workspace *ws);
+int dump_client_state(yajl_gen gen, Client *c);
+int dump_focus_state(yajl_gen gen);
+int dump_snapshot(yajl_gen gen, unsigned long generation);
 
 #endif  // YAJL_DUMPS_H_
@@ -71,7 +71,7 @@ static const uint64_t
 	StackerIcons = 0x100000000000, // adds a stacker icon hints in window titles
 	AltWindowTitles = 0x200000000000, // show alternate window titles, if present
 	BarBorderColBg = 0x400000000000, // optionally use the background colour of the bar for the border as well, rather than border colur
-	FuncPlaceholder140737488355328 = 0x800000000000,
+	Profiling = 0x800000000000, // records X requests, round-trips and time spent per event type and IPC command
 	FuncPlaceholder281474976710656 = 0x1000000000000,
 	FuncPlaceholder562949953421312 = 0x2000000000000,
 	FuncPlaceholder1125899906842624 = 0x4000000000000,
@@ -122,6 +122,7 @@ static const struct nv functionality_names[] = {
 	map(FocusOnNetActive),
 	map(GreedyMonitor),
 	map(NoBorders),
+	map(Profiling),
 	map(ResizeHints),
 	map(RestrictFocusstackToMonitor),
 	map(RioDrawIncludeBorders),